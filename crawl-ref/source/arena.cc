@@ -7,6 +7,8 @@
 
 #include "arena.h"
 
+#include <chrono>
+#include <cinttypes>
 #include <stdexcept>
 
 #include "act-iter.h"
@@ -18,6 +20,8 @@
 #include "item-name.h"
 #include "item-status-flag-type.h"
 #include "items.h"
+#include "json.h"
+#include "json-wrapper.h"
 #include "libutil.h"
 #include "los.h"
 #include "macro.h"
@@ -33,6 +37,8 @@
 #include "spl-miscast.h"
 #include "state.h"
 #include "stringutil.h"
+#include "syscalls.h"
+#include "tags.h"
 #include "teleport.h"
 #include "terrain.h"
 #ifdef USE_TILE
@@ -158,6 +164,7 @@ static void _results_popup(string msg, bool error=false)
 namespace arena
 {
     static bool skipped_arena_ui = true; // whether this is an interactive session
+    static bool headless = false; // -arena-jobs: no display and no delays
     static void write_error(const string &error);
 
     struct arena_error : public runtime_error
@@ -460,7 +467,8 @@ namespace arena
         random_uniques = strip_tag(spec, "random_uniques");
 
         const int ntrials = strip_number_tag(spec, "t:");
-        if (ntrials != TAG_UNFOUND && ntrials >= 1 && ntrials <= 99
+        if (ntrials != TAG_UNFOUND && ntrials >= 1
+            && ntrials <= (headless ? INT_MAX : 99)
             && !total_trials)
         {
             total_trials = ntrials;
@@ -558,6 +566,9 @@ namespace arena
 
     static void show_fight_banner(bool after_fight = false)
     {
+        if (headless)
+            return;
+
         int line = 1;
 
         cgotoxy(1, line++, GOTO_STAT);
@@ -617,7 +628,8 @@ namespace arena
         // XXX: now that you.species is valid, do a layout.
         // This is necessary to ensure that the stat window is positioned.
 #ifdef USE_TILE
-        tiles.resize();
+        if (!headless)
+            tiles.resize();
 #endif
 
         show_fight_banner();
@@ -860,8 +872,11 @@ namespace arena
 
     static void do_fight()
     {
-        viewwindow();
-        update_screen();
+        if (!headless)
+        {
+            viewwindow();
+            update_screen();
+        }
         clear_messages(true);
 
         {
@@ -883,12 +898,16 @@ namespace arena
                 do_respawn(faction_a);
                 do_respawn(faction_b);
                 balance_spawners();
-                ui::delay(Options.view_delay);
+                if (!headless)
+                    ui::delay(Options.view_delay);
                 clear_messages();
                 ASSERT(you.pet_target == MHITNOT);
             }
-            viewwindow();
-            update_screen();
+            if (!headless)
+            {
+                viewwindow();
+                update_screen();
+            }
         }
 
         if (contest_cancelled)
@@ -992,8 +1011,11 @@ namespace arena
         // Set various options from the arena spec's tags
         parse_monster_spec(); // may throw an arena_error
 
-        crawl_view.init_geometry();
-        expand_mlist(5);
+        if (!headless)
+        {
+            crawl_view.init_geometry();
+            expand_mlist(5);
+        }
 
         for (monster_type i = MONS_0; i < NUM_MONSTERS; ++i)
         {
@@ -1105,6 +1127,139 @@ namespace arena
 
         write_results();
     }
+
+    /// What happened in one fight of a headless batch.
+    struct fight_result
+    {
+        int winner;     ///< 0 for faction A, 1 for faction B, -1 for a tie.
+        int turns;
+        double seconds; ///< Wall time spent in the fight itself.
+    };
+
+    /**
+     * Run fights [first, last) of a headless batch. Fight n is seeded with
+     * seed + n and, as in an interactive run, the factions take turns to be
+     * placed first by fight number.
+     *
+     * @returns the results, marshalled, followed by an error message if a
+     *          fight couldn't be set up.
+     */
+    static vector<unsigned char> batch_fights(int first, int last,
+                                              uint64_t seed)
+    {
+        vector<fight_result> results;
+        string error;
+        for (int n = first; n < last; ++n)
+        {
+            rng::seed(seed + n);
+            trials_done = n;
+            const int a_wins = team_a_wins;
+            const int tied = ties;
+
+            try
+            {
+                setup_fight();
+            }
+            catch (const arena_error &err)
+            {
+                error = err.what();
+                break;
+            }
+
+            const auto start = chrono::steady_clock::now();
+            do_fight();
+            const chrono::duration<double> taken =
+                chrono::steady_clock::now() - start;
+
+            fight_result res;
+            res.winner = team_a_wins > a_wins ? 0 : ties > tied ? -1 : 1;
+            res.turns = turns;
+            res.seconds = taken.count();
+            results.push_back(res);
+        }
+
+        vector<unsigned char> buf;
+        writer th(&buf);
+        marshallUnsigned(th, results.size());
+        for (const fight_result &res : results)
+        {
+            marshallSigned(th, res.winner);
+            marshallSigned(th, res.turns);
+            th.write(&res.seconds, sizeof(res.seconds));
+        }
+        marshallString(th, error);
+        return buf;
+    }
+
+    static void write_batch_tsv(const vector<fight_result> &results,
+                                uint64_t seed)
+    {
+        FILE *tsv = fopen_u("arena.tsv", "w");
+        if (!tsv)
+            end(1, true, "Couldn't write arena.tsv");
+
+        fprintf(tsv, "Fight\tSeed\tWinner\tTurns\tSeconds\tUsecPerTurn\n");
+        for (int n = 0, size = results.size(); n < size; ++n)
+        {
+            const fight_result &res = results[n];
+            fprintf(tsv, "%d\t%" PRIu64 "\t%s\t%d\t%.6f\t%.1f\n",
+                    n + 1, seed + n,
+                    res.winner == 0 ? faction_a.desc.c_str() :
+                    res.winner == 1 ? faction_b.desc.c_str() : "tie",
+                    res.turns, res.seconds,
+                    res.turns ? res.seconds * 1e6 / res.turns : 0.0);
+        }
+        fclose(tsv);
+    }
+
+    static void write_batch_json(const vector<fight_result> &results,
+                                 uint64_t seed, int jobs, double wall_seconds)
+    {
+        const int fights = results.size();
+        int total_turns = 0;
+        double fight_seconds = 0;
+        for (const fight_result &res : results)
+        {
+            total_turns += res.turns;
+            fight_seconds += res.seconds;
+        }
+        const int b_wins = trials_done - team_a_wins - ties;
+
+        JsonWrapper json(json_mkobject());
+        json_append_member(json.node, "teams", json_mkstring(teams));
+        json_append_member(json.node, "faction_a",
+                           json_mkstring(faction_a.desc));
+        json_append_member(json.node, "faction_b",
+                           json_mkstring(faction_b.desc));
+        // Too big for a JSON number to hold exactly.
+        json_append_member(json.node, "seed",
+                           json_mkstring(make_stringf("%" PRIu64, seed)));
+        json_append_member(json.node, "jobs", json_mknumber(jobs));
+        json_append_member(json.node, "fights", json_mknumber(fights));
+        json_append_member(json.node, "a_wins", json_mknumber(team_a_wins));
+        json_append_member(json.node, "b_wins", json_mknumber(b_wins));
+        json_append_member(json.node, "ties", json_mknumber(ties));
+        json_append_member(json.node, "a_win_rate",
+                           json_mknumber(fights ? team_a_wins * 1.0 / fights
+                                                : 0));
+        json_append_member(json.node, "b_win_rate",
+                           json_mknumber(fights ? b_wins * 1.0 / fights : 0));
+        json_append_member(json.node, "mean_turns",
+                           json_mknumber(fights ? total_turns * 1.0 / fights
+                                                : 0));
+        json_append_member(json.node, "usec_per_turn",
+                           json_mknumber(total_turns
+                                         ? fight_seconds * 1e6 / total_turns
+                                         : 0));
+        json_append_member(json.node, "wall_seconds",
+                           json_mknumber(wall_seconds));
+
+        FILE *out = fopen_u("arena.json", "w");
+        if (!out)
+            end(1, true, "Couldn't write arena.json");
+        fprintf(out, "%s\n", json.to_string().c_str());
+        fclose(out);
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -1576,3 +1731,107 @@ NORETURN void run_arena(const newgame_def& choice, const string &default_arena_t
     }
     while (true);
 }
+
+/**
+ * Run the fights given by -arena without ever setting up the display, as
+ * quickly as possible, and spread over -arena-jobs processes.
+ *
+ * Writes the usual score line to arena.result, one row per fight to
+ * arena.tsv, and a summary (win rates, turn counts, wall time per turn) to
+ * arena.json.
+ */
+NORETURN void run_arena_batch(const string &teams)
+{
+    if (Options.game.type != GAME_TYPE_ARENA || teams.empty())
+        end(1, false, "-arena-jobs needs -arena \"<monsters> v <monsters>\"");
+
+    crawl_state.type = GAME_TYPE_ARENA;
+    arena::headless = true;
+    Options.view_delay = 0;
+    Options.use_animations = UA_NONE;
+
+    _init_arena();
+    init_level_connectivity();
+#ifdef WIZARD
+    unwind_bool wiz(you.wizard, true);
+#endif
+
+    try
+    {
+        arena::global_setup(teams);
+    }
+    catch (const arena::arena_error &error)
+    {
+        end(1, false, "Arena error: %s", error.what());
+    }
+
+    const int fights = max(arena::total_trials, 1);
+#ifdef TARGET_OS_WINDOWS
+    const int jobs = 1;
+#else
+    const int jobs = min(SysEnv.arena_jobs, fights);
+#endif
+    uint64_t seed = Options.seed;
+    while (!seed) // 0 = random seed
+        seed = rng::get_uint64();
+
+    printf("Running %d fight(s) of %s v %s in %d process(es), seed %" PRIu64
+           "...\n", fights, arena::faction_a.desc.c_str(),
+           arena::faction_b.desc.c_str(), jobs, seed);
+
+    const auto start = chrono::steady_clock::now();
+    const auto work = [=](int job) {
+        return arena::batch_fights(fights * job / jobs,
+                                   fights * (job + 1) / jobs, seed);
+    };
+    vector<vector<unsigned char>> bufs;
+#ifndef TARGET_OS_WINDOWS
+    if (jobs > 1)
+        bufs = run_forked_jobs(jobs, work);
+    else
+#endif
+        bufs.push_back(work(0));
+    const chrono::duration<double> wall = chrono::steady_clock::now() - start;
+
+    vector<arena::fight_result> results;
+    arena::trials_done = arena::team_a_wins = arena::ties = 0;
+    for (int job = 0; job < jobs; ++job)
+    {
+        if (bufs[job].empty())
+            end(1, false, "Arena worker %d of %d failed.", job + 1, jobs);
+
+        reader th(bufs[job]);
+        for (uint64_t n = unmarshallUnsigned(th); n; --n)
+        {
+            arena::fight_result res;
+            res.winner = unmarshallSigned(th);
+            res.turns = unmarshallSigned(th);
+            th.read(&res.seconds, sizeof(res.seconds));
+            results.push_back(res);
+
+            arena::trials_done++;
+            if (res.winner == 0)
+                arena::team_a_wins++;
+            else if (res.winner < 0)
+                arena::ties++;
+        }
+
+        const string error = unmarshallString(th);
+        if (!error.empty())
+            end(1, false, "Arena error: %s", error.c_str());
+    }
+
+    arena::write_batch_tsv(results, seed);
+    arena::write_batch_json(results, seed, jobs, wall.count());
+
+    arena::file = fopen_u("arena.result", "w");
+    arena::write_results();
+    arena::global_shutdown();
+
+    printf("Final score: %s (%d); %s (%d) [%d ties]\n",
+           arena::faction_a.desc.c_str(), arena::team_a_wins,
+           arena::faction_b.desc.c_str(),
+           arena::trials_done - arena::team_a_wins - arena::ties,
+           arena::ties);
+    end(0, false);
+}
@@ -14,7 +14,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <map>
 #include <set>
+#include <tuple>
 
 #include "act-iter.h"
 #include "areas.h"
@@ -2054,6 +2056,131 @@ int silver_damages_victim(actor* victim, int damage, string &dmg_msg)
     return ret;
 }
 
+// Everything about a monster tracer that can change its outcome while the
+// level itself stays put. The caster's sight (see invisible, nightvision) is
+// covered by source_id.
+struct tracer_key
+{
+    coord_def source, target;
+    mid_t source_id;
+    mon_attitude_type attitude;
+    int foe_ratio, range, extra_range_used;
+    beam_type flavour, real_flavour;
+    spell_type origin_spell;
+    string name;
+    int damage_num, damage_size, ench_power, hit, ex_size;
+    killer_type thrower;
+    ac_type ac_rule;
+    bool pierce, is_explosion, aimed_at_spot, affects_nothing, auto_hit;
+    bool is_targeting, use_target_as_pos, effect_known, explode_only;
+    bool explosion_hole;
+
+    tracer_key(const bolt &b, bool _explode_only, bool _explosion_hole)
+        : source(b.source), target(b.target), source_id(b.source_id),
+          attitude(b.attitude), foe_ratio(b.foe_ratio), range(b.range),
+          extra_range_used(b.extra_range_used), flavour(b.flavour),
+          real_flavour(b.real_flavour), origin_spell(b.origin_spell),
+          name(b.name), damage_num(b.damage.num), damage_size(b.damage.size),
+          ench_power(b.ench_power), hit(b.hit), ex_size(b.ex_size),
+          thrower(b.thrower), ac_rule(b.ac_rule), pierce(b.pierce),
+          is_explosion(b.is_explosion), aimed_at_spot(b.aimed_at_spot),
+          affects_nothing(b.affects_nothing), auto_hit(b.auto_hit),
+          is_targeting(b.is_targeting),
+          use_target_as_pos(b.use_target_as_pos),
+          effect_known(b.effect_known), explode_only(_explode_only),
+          explosion_hole(_explosion_hole)
+    {
+    }
+
+    bool operator<(const tracer_key &other) const
+    {
+        auto fields = [](const tracer_key &k)
+        {
+            return std::tie(k.source, k.target, k.source_id, k.attitude,
+                            k.foe_ratio, k.range, k.extra_range_used,
+                            k.flavour, k.real_flavour, k.origin_spell, k.name,
+                            k.damage_num, k.damage_size, k.ench_power, k.hit,
+                            k.ex_size, k.thrower, k.ac_rule, k.pierce,
+                            k.is_explosion, k.aimed_at_spot, k.affects_nothing,
+                            k.auto_hit, k.is_targeting, k.use_target_as_pos,
+                            k.effect_known, k.explode_only, k.explosion_hole);
+        };
+        return fields(*this) < fields(other);
+    }
+};
+
+static int _tracer_cache_depth = 0;
+static map<tracer_key, bolt> _tracer_cache;
+
+tracer_cache_scope::tracer_cache_scope()
+{
+    ++_tracer_cache_depth;
+}
+
+tracer_cache_scope::~tracer_cache_scope()
+{
+    if (--_tracer_cache_depth == 0)
+        _tracer_cache.clear();
+}
+
+void invalidate_tracer_cache()
+{
+    _tracer_cache.clear();
+}
+
+// Copy what firing a tracer leaves behind in a beam.
+static void _copy_tracer_result(bolt &to, const bolt &from)
+{
+    to.obvious_effect     = from.obvious_effect;
+    to.seen               = from.seen;
+    to.heard              = from.heard;
+    to.path_taken         = from.path_taken;
+    to.extra_range_used   = from.extra_range_used;
+    to.aimed_at_feet      = from.aimed_at_feet;
+    to.msg_generated      = from.msg_generated;
+    to.noise_generated    = from.noise_generated;
+    to.passed_target      = from.passed_target;
+    to.in_explosion_phase = from.in_explosion_phase;
+    to.hit_count          = from.hit_count;
+    to.foe_info           = from.foe_info;
+    to.friend_info        = from.friend_info;
+    to.beam_cancelled     = from.beam_cancelled;
+    to.bounces            = from.bounces;
+    to.bounce_pos         = from.bounce_pos;
+    to.reflections        = from.reflections;
+    to.reflector          = from.reflector;
+    to.use_target_as_pos  = from.use_target_as_pos;
+    to.ray                = from.ray;
+    to.target             = from.target;
+    to.colour             = from.colour;
+    to.flavour            = from.flavour;
+    to.real_flavour       = from.real_flavour;
+}
+
+// Beams carrying other state (an item, a sub-explosion, a hand-picked ray)
+// or left over from an earlier trace are always traced afresh.
+static bool _tracer_cacheable(const bolt &pbolt)
+{
+    return _tracer_cache_depth > 0
+           && !pbolt.special_explosion
+           && !pbolt.item
+           && !pbolt.chose_ray
+           && pbolt.hit_count.empty();
+}
+
+static void _fire_tracer_bolt(bolt &pbolt, bool explode_only,
+                              bool explosion_hole)
+{
+    // Fire!
+    if (explode_only)
+        pbolt.explode(false, explosion_hole);
+    else
+        pbolt.fire();
+
+    // Unset tracer flag (convenience).
+    pbolt.is_tracer = false;
+}
+
 //  Used by monsters in "planning" which spell to cast. Fires off a "tracer"
 //  which tells the monster what it'll hit if it breathes/casts etc.
 //
@@ -2098,14 +2225,29 @@ void fire_tracer(const monster* mons, bolt &pbolt, bool explode_only,
 
     pbolt.in_explosion_phase = false;
 
-    // Fire!
-    if (explode_only)
-        pbolt.explode(false, explosion_hole);
-    else
-        pbolt.fire();
+    if (!_tracer_cacheable(pbolt))
+    {
+        _fire_tracer_bolt(pbolt, explode_only, explosion_hole);
+        return;
+    }
 
-    // Unset tracer flag (convenience).
-    pbolt.is_tracer = false;
+    const tracer_key key(pbolt, explode_only, explosion_hole);
+    auto cached = _tracer_cache.find(key);
+    if (cached != _tracer_cache.end())
+    {
+        _copy_tracer_result(pbolt, cached->second);
+        pbolt.is_tracer = false;
+        return;
+    }
+
+    const uint64_t rng_before = rng::peek_uint64();
+    _fire_tracer_bolt(pbolt, explode_only, explosion_hole);
+
+    // A tracer that rolled dice (e.g. guessing where an invisible player is)
+    // might come out differently next time, and replaying it would skip
+    // the rolls; only remember deterministic ones.
+    if (rng::peek_uint64() == rng_before)
+        _tracer_cache.emplace(key, pbolt);
 }
 
 vector<coord_def> create_feat_splash(coord_def center,
@@ -331,6 +331,21 @@ bool curare_actor(actor* source, actor* target, int levels, string name,
 int silver_damages_victim(actor* victim, int damage, string &dmg_msg);
 void fire_tracer(const monster* mons, bolt &pbolt,
                   bool explode_only = false, bool explosion_hole = false);
+
+/**
+ * While one of these is alive, fire_tracer() remembers the outcome of each
+ * tracer it fires and hands it back for an identical beam instead of tracing
+ * again. Scopes nest; the cache is emptied when the outermost one ends, and
+ * whenever an actor moves or terrain changes.
+ */
+class tracer_cache_scope
+{
+public:
+    tracer_cache_scope();
+    ~tracer_cache_scope();
+};
+void invalidate_tracer_cache();
+
 spret zapping(zap_type ztype, int power, bolt &pbolt,
                    bool needs_tracer = false, const char* msg = nullptr,
                    bool fail = false);
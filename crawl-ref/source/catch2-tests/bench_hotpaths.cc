@@ -0,0 +1,286 @@
+/*
+ * Microbenchmarks of code that runs many times a turn, or on every level
+ * change. Build and run them with "make benchmarks", which writes Catch2's
+ * XML report to benchmarks.xml.
+ *
+ * The levels are generated here from fixed seeds rather than by the dungeon
+ * builder, which needs far more of the game set up than a test binary has.
+ * Changing a seed or the generator changes every result, so add new levels
+ * instead of altering old ones.
+ */
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "coordit.h"
+#include "env.h"
+#include "items.h"
+#include "los.h"
+#include "losglobal.h"
+#include "mon-pathfind.h"
+#include "mon-pick.h"
+#include "mon-util.h"
+#include "noise.h"
+#include "package.h"
+#include "random.h"
+#include "state.h"
+#include "stringutil.h"
+#include "tag-version.h"
+#include "tags.h"
+#include "travel.h"
+#include "unwind.h"
+
+#include "test_player_fixture.h"
+
+struct bench_level
+{
+    const char *name;
+    uint64_t seed;
+    int obstacle_percent; // of cells away from the edge corridor
+};
+
+static const bench_level bench_levels[] =
+{
+    { "open", 1, 5 },
+    { "cave", 2, 35 },
+};
+
+// Opposite corners of the corridor around the edge of every level.
+static const coord_def corner1(X_BOUND_1 + 1, Y_BOUND_1 + 1);
+static const coord_def corner2(X_BOUND_2 - 1, Y_BOUND_2 - 1);
+
+static bool _on_edge_corridor(const coord_def &p)
+{
+    return p.x == corner1.x || p.x == corner2.x
+           || p.y == corner1.y || p.y == corner2.y;
+}
+
+// Fill the map with floor scattered with rock and trees, which the player
+// knows all of. A corridor round the edge keeps the corners connected.
+static void _build_level(const bench_level &lev)
+{
+    rng::subgenerator level_rng(lev.seed);
+
+    for (rectangle_iterator ri(0); ri; ++ri)
+    {
+        dungeon_feature_type feat = DNGN_FLOOR;
+        if (!in_bounds(*ri))
+            feat = DNGN_PERMAROCK_WALL;
+        else if (!_on_edge_corridor(*ri)
+                 && x_chance_in_y(lev.obstacle_percent, 100))
+        {
+            feat = coinflip() ? DNGN_ROCK_WALL : DNGN_TREE;
+        }
+
+        env.grid(*ri) = feat;
+        env.map_knowledge(*ri).clear();
+        env.map_knowledge(*ri).set_feature(feat);
+    }
+
+    invalidate_los();
+}
+
+// Floor cells to look and make noise from, chosen by the level's seed.
+static vector<coord_def> _sample_floor(const bench_level &lev, int count)
+{
+    rng::subgenerator sample_rng(lev.seed, 1);
+
+    vector<coord_def> cells;
+    while ((int) cells.size() < count)
+    {
+        const coord_def p = random_in_bounds();
+        if (env.grid(p) == DNGN_FLOOR)
+            cells.push_back(p);
+    }
+    return cells;
+}
+
+static string _bench_name(const char *what, const bench_level &lev)
+{
+    return make_stringf("%s, %s level", what, lev.name);
+}
+
+TEST_CASE_METHOD(MockPlayerYouTestsFixture, "Benchmark LOS", "[benchmark]")
+{
+    for (const bench_level &lev : bench_levels)
+    {
+        _build_level(lev);
+        const vector<coord_def> centres = _sample_floor(lev, 100);
+
+        BENCHMARK(_bench_name("losight x100", lev))
+        {
+            los_grid sh;
+            int visible = 0;
+            for (const coord_def &c : centres)
+            {
+                losight(sh, c);
+                visible += sh(coord_def(1, 1));
+            }
+            return visible;
+        };
+
+        // From each centre to every cell in range, starting with an empty
+        // cache each time, as after terrain has changed.
+        BENCHMARK(_bench_name("cell_see_cell x100 uncached", lev))
+        {
+            invalidate_los();
+            int visible = 0;
+            for (const coord_def &c : centres)
+                for (radius_iterator ri(c, LOS_RADIUS, C_SQUARE); ri; ++ri)
+                    visible += cell_see_cell(c, *ri, LOS_DEFAULT);
+            return visible;
+        };
+
+        BENCHMARK(_bench_name("cell_see_cell x100 cached", lev))
+        {
+            int visible = 0;
+            for (const coord_def &c : centres)
+                for (radius_iterator ri(c, LOS_RADIUS, C_SQUARE); ri; ++ri)
+                    visible += cell_see_cell(c, *ri, LOS_DEFAULT);
+            return visible;
+        };
+    }
+}
+
+TEST_CASE_METHOD(MockPlayerYouTestsFixture, "Benchmark pathfinding",
+                 "[benchmark]")
+{
+    // travel_pathfind refuses to run without a game in progress.
+    unwind_bool in_game(crawl_state.need_save, true);
+
+    for (const bench_level &lev : bench_levels)
+    {
+        _build_level(lev);
+
+        BENCHMARK(_bench_name("monster_pathfind corner to corner", lev))
+        {
+            monster_pathfind mp;
+            mp.init_pathfind(corner1, corner2);
+            return mp.backtrack().size();
+        };
+
+        BENCHMARK(_bench_name("travel_pathfind corner to corner", lev))
+        {
+            travel_pathfind tp;
+            tp.set_src_dst(corner1, corner2);
+            return tp.pathfind(RMODE_TRAVEL);
+        };
+
+        // With the whole level known, explore floods all of it.
+        BENCHMARK(_bench_name("travel_pathfind explore flood", lev))
+        {
+            travel_pathfind tp;
+            tp.set_floodseed(corner1);
+            return tp.pathfind(RMODE_EXPLORE);
+        };
+    }
+}
+
+TEST_CASE_METHOD(MockPlayerYouTestsFixture, "Benchmark noise propagation",
+                 "[benchmark]")
+{
+    static noise_grid noise;
+
+    for (const bench_level &lev : bench_levels)
+    {
+        _build_level(lev);
+        const vector<coord_def> sources = _sample_floor(lev, 10);
+
+        // As loud as a shout.
+        BENCHMARK(_bench_name("propagate_noise x10", lev))
+        {
+            for (const coord_def &s : sources)
+            {
+                noise.register_noise(noise_t(s, "", 12 * 1000));
+                noise.propagate_noise();
+                noise.reset();
+            }
+        };
+    }
+}
+
+TEST_CASE_METHOD(MockPlayerYouTestsFixture, "Benchmark level saving",
+                 "[benchmark]")
+{
+    for (const bench_level &lev : bench_levels)
+    {
+        _build_level(lev);
+
+        vector<unsigned char> level_data;
+        BENCHMARK(_bench_name("tag_write", lev))
+        {
+            level_data.clear();
+            writer outf(&level_data);
+            tag_write(TAG_LEVEL, outf);
+            return level_data.size();
+        };
+
+        unwind_var<int> minor(crawl_state.minor_version, TAG_MINOR_VERSION);
+        BENCHMARK(_bench_name("tag_read", lev))
+        {
+            reader inf(level_data, TAG_MINOR_VERSION);
+            tag_read(inf, TAG_LEVEL);
+            return env.grid(corner1);
+        };
+
+        const string file = "benchmark-package.tmp";
+        package save(file.c_str(), true, true);
+        BENCHMARK(_bench_name("package write and commit", lev))
+        {
+            {
+                writer outf(&save, "level");
+                outf.write(level_data.data(), level_data.size());
+            }
+            save.commit();
+            return save.get_size();
+        };
+        save.unlink();
+    }
+}
+
+TEST_CASE("Benchmark item names", "[benchmark]")
+{
+    static const char * const names[] =
+    {
+        "long sword", "arrow", "scale mail", "pair of boots",
+        "potion of heal wounds", "scroll of fear", "wand of flame",
+        "ring of protection from fire", "amulet of faith",
+    };
+
+    vector<item_def> items;
+    for (const char *name : names)
+    {
+        item_def item;
+        REQUIRE(get_item_by_exact_name(item, name));
+        items.push_back(item);
+    }
+
+    for (description_level_type desc : { DESC_PLAIN, DESC_A, DESC_THE })
+    {
+        BENCHMARK(make_stringf("item_def::name x%d, description level %d",
+                               (int) items.size(), desc))
+        {
+            size_t length = 0;
+            for (const item_def &item : items)
+                length += item.name(desc).size();
+            return length;
+        };
+    }
+}
+
+TEST_CASE("Benchmark monster picking", "[benchmark]")
+{
+    init_monsters();
+    rng::subgenerator pick_rng(1);
+
+    for (const level_id place : { level_id(BRANCH_DUNGEON, 5),
+                                  level_id(BRANCH_DEPTHS, 3) })
+    {
+        BENCHMARK(make_stringf("pick_monster, %s", place.describe().c_str()))
+        {
+            return pick_monster(place);
+        };
+    }
+}
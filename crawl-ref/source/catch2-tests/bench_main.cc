@@ -0,0 +1,8 @@
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "fake-main.hpp"
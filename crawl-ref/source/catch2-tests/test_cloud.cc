@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "cloud.h"
+
+static cloud_struct _make_cloud(cloud_type type, int decay)
+{
+    cloud_struct cloud;
+    cloud.type = type;
+    cloud.decay = decay;
+    return cloud;
+}
+
+TEST_CASE("cloud_grid stores clouds by position", "[single-file]")
+{
+    cloud_grid grid;
+    const coord_def a(10, 10), b(20, 15), c(30, 40);
+
+    SECTION("An empty grid has no clouds")
+    {
+        REQUIRE(grid.empty());
+        REQUIRE(grid.find(a) == nullptr);
+    }
+
+    SECTION("put() stores a copy at the given position")
+    {
+        cloud_struct &stored = grid.put(a, _make_cloud(CLOUD_FIRE, 50));
+
+        REQUIRE(grid.size() == 1);
+        REQUIRE(grid.find(a) == &stored);
+        REQUIRE(stored.pos == a);
+        REQUIRE(stored.type == CLOUD_FIRE);
+        REQUIRE(stored.decay == 50);
+    }
+
+    SECTION("put() on an occupied cell replaces the cloud")
+    {
+        grid.put(a, _make_cloud(CLOUD_FIRE, 50));
+        grid.put(a, _make_cloud(CLOUD_COLD, 30));
+
+        REQUIRE(grid.size() == 1);
+        REQUIRE(grid.find(a)->type == CLOUD_COLD);
+    }
+
+    SECTION("erase() keeps the other clouds in place")
+    {
+        cloud_struct &first = grid.put(a, _make_cloud(CLOUD_FIRE, 50));
+        grid.put(b, _make_cloud(CLOUD_COLD, 30));
+        cloud_struct &last = grid.put(c, _make_cloud(CLOUD_POISON, 20));
+
+        grid.erase(b);
+
+        REQUIRE(grid.size() == 2);
+        REQUIRE(grid.find(b) == nullptr);
+        REQUIRE(grid.find(a) == &first);
+        REQUIRE(grid.find(c) == &last);
+        REQUIRE(last.type == CLOUD_POISON);
+
+        grid.erase(a);
+        grid.erase(c);
+        REQUIRE(grid.empty());
+        REQUIRE(grid.cells().empty());
+    }
+
+    SECTION("clear() removes every cloud")
+    {
+        grid.put(a, _make_cloud(CLOUD_FIRE, 50));
+        grid.put(b, _make_cloud(CLOUD_COLD, 30));
+
+        grid.clear();
+
+        REQUIRE(grid.empty());
+        REQUIRE(grid.find(a) == nullptr);
+        REQUIRE(grid.find(b) == nullptr);
+    }
+
+    SECTION("restore() puts back the clouds of a snapshot()")
+    {
+        grid.put(a, _make_cloud(CLOUD_FIRE, 50));
+        grid.put(b, _make_cloud(CLOUD_COLD, 30));
+        const vector<coord_def> cells = grid.cells();
+        const vector<cloud_struct> saved = grid.snapshot();
+
+        grid.erase(a);
+        grid.put(b, _make_cloud(CLOUD_POISON, 20));
+        grid.put(c, _make_cloud(CLOUD_FIRE, 10));
+        grid.restore(saved);
+
+        REQUIRE(grid.size() == 2);
+        REQUIRE(grid.cells() == cells);
+        REQUIRE(grid.find(a)->type == CLOUD_FIRE);
+        REQUIRE(grid.find(a)->decay == 50);
+        REQUIRE(grid.find(b)->type == CLOUD_COLD);
+        REQUIRE(grid.find(c) == nullptr);
+    }
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "screen-shadow.h"
+
+// How many cells of a frame puttext() would draw.
+static int _cells_drawn(screen_shadow &shadow, int frame)
+{
+    int drawn = 0;
+    for (int y = 0; y < 5; ++y)
+        for (int x = 0; x < 10; ++x)
+            if (shadow.draw(y, x, 'a' + (x + y + frame) % 26, 0, 1))
+                drawn++;
+    return drawn;
+}
+
+TEST_CASE("screen_shadow skips cells that are unchanged", "[single-file]")
+{
+    screen_shadow shadow;
+    shadow.resize(24, 80);
+
+    SECTION("The first frame draws every cell")
+    {
+        REQUIRE(_cells_drawn(shadow, 0) == 50);
+    }
+
+    SECTION("Drawing the same frame again draws nothing")
+    {
+        _cells_drawn(shadow, 0);
+        REQUIRE(_cells_drawn(shadow, 0) == 0);
+    }
+
+    SECTION("A changed glyph or attribute is drawn")
+    {
+        _cells_drawn(shadow, 0);
+        REQUIRE(shadow.draw(2, 3, 'z', 0, 1));
+        REQUIRE(shadow.draw(2, 4, 'a' + 6, 1, 1));
+        REQUIRE(shadow.draw(2, 5, 'a' + 7, 0, 2));
+        REQUIRE_FALSE(shadow.draw(2, 6, 'a' + 8, 0, 1));
+    }
+
+    SECTION("Cells drawn over by something else are drawn again")
+    {
+        _cells_drawn(shadow, 0);
+        shadow.forget(1, 2, 5);
+        REQUIRE(_cells_drawn(shadow, 0) == 3);
+        shadow.forget_all();
+        REQUIRE(_cells_drawn(shadow, 0) == 50);
+    }
+
+    SECTION("A resize forgets everything")
+    {
+        _cells_drawn(shadow, 0);
+        shadow.resize(30, 100);
+        REQUIRE(_cells_drawn(shadow, 0) == 50);
+    }
+
+    SECTION("Cells off the screen are always drawn")
+    {
+        REQUIRE(shadow.draw(24, 0, 'a', 0, 1));
+        REQUIRE(shadow.draw(24, 0, 'a', 0, 1));
+        REQUIRE(shadow.draw(0, -1, 'a', 0, 1));
+    }
+}
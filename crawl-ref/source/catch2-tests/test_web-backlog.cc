@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include "AppHdr.h"
+
+#include "web-backlog.h"
+
+// A backlog like that of a receiver that stopped reading while the player had
+// a popup open and kept walking about: the popup, then more map updates than
+// it may hold.
+static deque<string> _overflowed_backlog(size_t &bytes)
+{
+    deque<string> queue;
+    queue.push_back("{\"msg\":\"player\",\"hp\":10},"
+                    "{\"msg\":\"ui-push\",\"type\":\"describe-item\","
+                    "\"generation_id\":3}\n");
+    queue.push_back("*{\"msg\":\"flush_messages\"}\n");
+    const string map_update = "{\"msg\":\"map\",\"cells\":[" + string(4096, ' ')
+                              + "]}\n";
+    bytes = queue[0].size() + queue[1].size();
+    while (bytes <= 4 * 1024 * 1024)
+    {
+        queue.push_back(map_update);
+        bytes += map_update.size();
+    }
+    queue.push_back("{\"msg\":\"ui-pop\"}\n");
+    bytes += queue.back().size();
+    return queue;
+}
+
+TEST_CASE("Trimming a slow receiver's backlog keeps the popups",
+          "[single-file]")
+{
+    size_t bytes = 0;
+    deque<string> queue = _overflowed_backlog(bytes);
+    const deque<string> before = queue;
+
+    SECTION("Game state updates are dropped, popups and webserver messages "
+            "stay in order")
+    {
+        const size_t kept_bytes = trim_web_backlog(queue, 0);
+        REQUIRE(queue.size() == 3);
+        REQUIRE(queue[0] == before[0]);
+        REQUIRE(queue[1] == before[1]);
+        REQUIRE(queue[2] == before.back());
+        REQUIRE(kept_bytes == before[0].size() + before[1].size()
+                              + before.back().size());
+        REQUIRE(kept_bytes < bytes);
+    }
+
+    SECTION("A half sent front message stays")
+    {
+        queue.pop_front();
+        queue.pop_front();
+        trim_web_backlog(queue, 100);
+        REQUIRE(queue.size() == 2);
+        REQUIRE(queue[0] == before[2]);
+        REQUIRE(queue[1] == before.back());
+    }
+
+    SECTION("Menu changes must arrive after a trim too")
+    {
+        REQUIRE(web_message_must_arrive("{\"msg\":\"menu\",\"items\":[]}"));
+        REQUIRE(web_message_must_arrive("{\"msg\":\"update_menu_items\"}"));
+        REQUIRE(web_message_must_arrive("{\"msg\":\"close_menu\"}"));
+        REQUIRE_FALSE(web_message_must_arrive("{\"msg\":\"map\"}"));
+        REQUIRE_FALSE(web_message_must_arrive(
+            "{\"msg\":\"messages\",\"messages\":[{\"text\":"
+            "\"\\\"msg\\\":\\\"ui-pop\\\"\"}]}"));
+    }
+}
@@ -15,6 +15,7 @@
 #include "art-enum.h"
 #include "colour.h"
 #include "coordit.h"
+#include "dbg-prof.h"
 #include "dungeon.h"
 #include "english.h"
 #include "god-conduct.h"
@@ -40,9 +41,92 @@
 #include "rltiles/tiledef-main.h"
 #include "unwind.h"
 
+cloud_grid::cloud_grid() : slot(-1)
+{
+}
+
+cloud_struct *cloud_grid::find(const coord_def &p)
+{
+    return slot(p) >= 0 ? &clouds(p) : nullptr;
+}
+
+const cloud_struct *cloud_grid::find(const coord_def &p) const
+{
+    return slot(p) >= 0 ? &clouds(p) : nullptr;
+}
+
+/**
+ * Store a copy of a cloud at the given position, replacing any cloud already
+ * there.
+ *
+ * @param p         Where to put the cloud; overrides the cloud's own pos.
+ * @param cloud     The cloud to copy.
+ * @return          The stored cloud.
+ */
+cloud_struct &cloud_grid::put(const coord_def &p, const cloud_struct &cloud)
+{
+    ASSERT_IN_BOUNDS(p);
+    if (slot(p) < 0)
+    {
+        slot(p) = occupied.size();
+        occupied.push_back(p);
+    }
+    clouds(p) = cloud;
+    clouds(p).pos = p;
+    return clouds(p);
+}
+
+void cloud_grid::erase(const coord_def &p)
+{
+    const int i = slot(p);
+    if (i < 0)
+        return;
+
+    const coord_def last = occupied.back();
+    occupied[i] = last;
+    slot(last) = i;
+    occupied.pop_back();
+
+    slot(p) = -1;
+    clouds(p) = cloud_struct();
+}
+
+void cloud_grid::clear()
+{
+    for (const coord_def &p : occupied)
+    {
+        slot(p) = -1;
+        clouds(p) = cloud_struct();
+    }
+    occupied.clear();
+}
+
+/// Copy out the clouds, in the order of cells(), for restore().
+vector<cloud_struct> cloud_grid::snapshot() const
+{
+    vector<cloud_struct> saved;
+    saved.reserve(occupied.size());
+    for (const coord_def &p : occupied)
+        saved.push_back(clouds(p));
+    return saved;
+}
+
+/**
+ * Replace every cloud with those of a snapshot(). Only occupied cells are
+ * touched, so this is cheap when there are few clouds.
+ *
+ * @param saved     The clouds from snapshot(); cells() gets back its order.
+ */
+void cloud_grid::restore(const vector<cloud_struct> &saved)
+{
+    clear();
+    for (const cloud_struct &cloud : saved)
+        put(cloud.pos, cloud);
+}
+
 cloud_struct* cloud_at(coord_def pos)
 {
-    return map_find(env.cloud, pos);
+    return env.cloud.find(pos);
 }
 
 /// damage = base + random2avg(random, random/15 + 1)
@@ -413,10 +497,9 @@ static int _spread_cloud(const cloud_struct &cloud)
         if (newdecay >= cloud.decay)
             newdecay = cloud.decay - 1;
 
-        env.cloud[*ai] = cloud;
-        env.cloud[*ai].pos = *ai;
-        env.cloud[*ai].decay = newdecay;
-        _los_cloud_changed(env.cloud[*ai].pos, env.cloud[*ai].type, CLOUD_NONE);
+        cloud_struct &spread = env.cloud.put(*ai, cloud);
+        spread.decay = newdecay;
+        _los_cloud_changed(spread.pos, spread.type, CLOUD_NONE);
 
         extra_decay += 8;
     }
@@ -440,10 +523,9 @@ static void _spread_fire(const cloud_struct &cloud)
         // burning trees produce flames all around
         if (!cell_is_solid(*ai) && make_flames)
         {
-            env.cloud[*ai] = cloud;
-            env.cloud[*ai].type = CLOUD_FIRE;
-            env.cloud[*ai].pos = *ai;
-            env.cloud[*ai].decay = cloud.decay / 2 + 1;
+            cloud_struct &flames = env.cloud.put(*ai, cloud);
+            flames.type = CLOUD_FIRE;
+            flames.decay = cloud.decay / 2 + 1;
         }
 
         // forest fire doesn't spread in all directions at once,
@@ -460,9 +542,7 @@ static void _spread_fire(const cloud_struct &cloud)
         if (you.see_cell(*ai))
             mpr("The forest fire spreads!");
         destroy_wall(*ai);
-        env.cloud[*ai] = cloud;
-        env.cloud[*ai].pos = *ai;
-        env.cloud[*ai].decay = random2(30) + 25;
+        env.cloud.put(*ai, cloud).decay = random2(30) + 25;
         if (cloud.whose == KC_YOU)
             did_god_conduct(DID_KILL_PLANT, 1);
         else if (cloud.whose == KC_FRIENDLY && !crawl_state.game_is_arena())
@@ -486,10 +566,11 @@ static void _cloud_interacts_with_terrain(const cloud_struct &cloud)
             && one_chance_in(14))
         {
             const cloud_type old = cloud_type_at(p);
-            env.cloud[p] = cloud_struct(p, CLOUD_STEAM, 2 + random2(5),
-                                        11, cloud.whose, cloud.killer,
-                                        cloud.source, -1);
-            _los_cloud_changed(p, env.cloud[p].type, old);
+            const cloud_struct &steam =
+                env.cloud.put(p, cloud_struct(p, CLOUD_STEAM, 2 + random2(5),
+                                              11, cloud.whose, cloud.killer,
+                                              cloud.source, -1));
+            _los_cloud_changed(p, steam.type, old);
         }
     }
 }
@@ -608,14 +689,19 @@ static void _handle_spectral_cloud(const cloud_struct& cloud)
 
 void manage_clouds()
 {
+    prof_timer timer(PROF_CLOUDS);
+
     // We can't iterate over env.cloud directly because _dissipate_cloud
-    // will remove this cloud and invalidate our iterator.
-    vector<cloud_struct *> cloud_ptrs;
-    for (auto& entry : env.cloud)
-        cloud_ptrs.push_back(&entry.second);
+    // will remove this cloud and reorder the list. Go through the clouds
+    // in position order so that the rolls are made in a consistent order.
+    vector<coord_def> cloud_locs = env.cloud.cells();
+    sort(cloud_locs.begin(), cloud_locs.end());
 
-    for (auto ptr : cloud_ptrs)
+    for (const coord_def &pos : cloud_locs)
     {
+        cloud_struct* ptr = cloud_at(pos);
+        if (!ptr)
+            continue;
         cloud_struct& cloud = *ptr;
 
 #ifdef ASSERTS
@@ -696,10 +782,8 @@ void delete_cloud(coord_def p)
 void delete_all_clouds()
 {
     // We can't iterate over env.cloud directly because delete_cloud
-    // will remove this cloud and invalidate our iterator.
-    vector<coord_def> cloud_locs;
-    for (auto& entry : env.cloud)
-        cloud_locs.push_back(entry.first);
+    // will remove this cloud and reorder the list.
+    const vector<coord_def> cloud_locs = env.cloud.cells();
 
     for (auto pos : cloud_locs)
         delete_cloud(pos);
@@ -715,11 +799,10 @@ void move_cloud(coord_def src, coord_def newpos)
 
     const cloud_type old = cloud_type_at(newpos);
 
-    env.cloud[newpos] = env.cloud[src];
+    const cloud_struct &moved = env.cloud.put(newpos, *cloud_at(src));
     env.cloud.erase(src);
-    env.cloud[newpos].pos = newpos;
-    _los_cloud_changed(src, CLOUD_NONE, env.cloud[newpos].type);
-    _los_cloud_changed(newpos, env.cloud[newpos].type, old);
+    _los_cloud_changed(src, CLOUD_NONE, moved.type);
+    _los_cloud_changed(newpos, moved.type, old);
 }
 
 void swap_clouds(coord_def p1, coord_def p2)
@@ -737,13 +820,11 @@ void swap_clouds(coord_def p1, coord_def p2)
         return;
     }
 
-    cloud_struct temp = env.cloud[p1];
-    env.cloud[p1] = env.cloud[p2];
-    env.cloud[p2] = temp;
-    env.cloud[p1].pos = p1;
-    env.cloud[p2].pos = p2;
-    _los_cloud_changed(p1, env.cloud[p1].type, env.cloud[p2].type);
-    _los_cloud_changed(p2, env.cloud[p2].type, env.cloud[p1].type);
+    const cloud_struct temp = *cloud_at(p1);
+    const cloud_struct &c1 = env.cloud.put(p1, *cloud_at(p2));
+    const cloud_struct &c2 = env.cloud.put(p2, temp);
+    _los_cloud_changed(p1, c1.type, c2.type);
+    _los_cloud_changed(p2, c2.type, c1.type);
 }
 
 // Places a cloud with the given stats assuming one doesn't already
@@ -846,10 +927,11 @@ void place_cloud(cloud_type cl_type, const coord_def& ctarget, int cl_range,
     // possible to overwrite an opaque cloud with a non-opaque one; OOD will do
     // this.
     const cloud_type old = cloud ? cloud->type : CLOUD_NONE;
-    env.cloud[ctarget] = cloud_struct(ctarget, cl_type, cl_range * 10,
-            _actual_spread_rate(cl_type, spread_rate), whose, killer, source,
-            excl_rad);
-    _los_cloud_changed(ctarget, env.cloud[ctarget].type, old);
+    const cloud_struct &placed =
+        env.cloud.put(ctarget, cloud_struct(ctarget, cl_type, cl_range * 10,
+                          _actual_spread_rate(cl_type, spread_rate), whose,
+                          killer, source, excl_rad));
+    _los_cloud_changed(ctarget, placed.type, old);
 }
 
 bool is_opaque_cloud(cloud_type ctype)
@@ -1800,11 +1882,14 @@ void remove_tornado_clouds(mid_t whose)
     // spell (excluding immobile and mindless casters).
 
     // We can't iterate over env.cloud directly because delete_cloud
-    // will remove this cloud and invalidate our iterator.
+    // will remove this cloud and reorder the list.
     vector<coord_def> tornados;
-    for (auto& entry : env.cloud)
-        if (entry.second.type == CLOUD_TORNADO && entry.second.source == whose)
-            tornados.push_back(entry.first);
+    for (const coord_def &pos : env.cloud.cells())
+    {
+        const cloud_struct &cloud = *cloud_at(pos);
+        if (cloud.type == CLOUD_TORNADO && cloud.source == whose)
+            tornados.push_back(pos);
+    }
 
     for (auto pos : tornados)
         delete_cloud(pos);
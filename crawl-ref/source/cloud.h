@@ -39,6 +39,40 @@ struct cloud_struct
     static killer_type   whose_to_killer(kill_category whose);
 };
 
+/**
+ * The clouds on a level.
+ *
+ * Each cloud is stored in place in a grid cell at its position, so lookups
+ * are constant-time and a pointer to a cloud stays valid until that cloud is
+ * deleted. A compact list of the occupied cells is kept alongside for
+ * iteration; deletion swaps the last entry into the freed slot.
+ */
+class cloud_grid
+{
+public:
+    cloud_grid();
+
+    cloud_struct *find(const coord_def &p);
+    const cloud_struct *find(const coord_def &p) const;
+    cloud_struct &put(const coord_def &p, const cloud_struct &cloud);
+    void erase(const coord_def &p);
+    void clear();
+    vector<cloud_struct> snapshot() const;
+    void restore(const vector<cloud_struct> &saved);
+
+    size_t size() const { return occupied.size(); }
+    bool empty() const { return occupied.empty(); }
+
+    /// The cells holding clouds, in no particular order. Copy this before
+    /// iterating if clouds may be created or deleted along the way.
+    const vector<coord_def> &cells() const { return occupied; }
+
+private:
+    FixedArray<cloud_struct, GXM, GYM> clouds;
+    FixedArray<short, GXM, GYM> slot; ///< index into occupied, or -1
+    vector<coord_def> occupied;
+};
+
 enum cloud_tile_variation
 {
     CTVARY_NONE,     ///< fixed tile (or special case)
@@ -5,6 +5,8 @@
 #include <algorithm>
 
 #include "cluautil.h"
+#include "dbg-luaprof.h"
+#include "dbg-trace.h"
 #include "dlua.h"
 #include "end.h"
 #include "files.h"
@@ -29,7 +31,7 @@
 #endif
 
 static int  _clua_panic(lua_State *);
-static void _clua_throttle_hook(lua_State *, lua_Debug *);
+static void _clua_hook(lua_State *, lua_Debug *);
 #ifndef NO_CUSTOM_ALLOCATOR
 static void *_clua_allocator(void *ud, void *ptr, size_t osize, size_t nsize);
 #endif
@@ -115,6 +117,15 @@ void CLua::gc()
     lua_gc(state(), LUA_GCCOLLECT, 0);
 }
 
+/// The size of the interpreter's heap, or 0 if it hasn't been started.
+size_t CLua::heap_bytes() const
+{
+    if (!_state)
+        return 0;
+    return lua_gc(_state, LUA_GCCOUNT, 0) * size_t(1024)
+           + lua_gc(_state, LUA_GCCOUNTB, 0);
+}
+
 void CLua::save(writer &outf)
 {
     if (!_state)
@@ -218,27 +229,30 @@ void CLua::set_error(int err, lua_State *ls)
     error = serr? serr : "<Unknown error>";
 }
 
+// Set up the hook for the throttle and the profiler, which share the one
+// hook a Lua state can have.
 void CLua::init_throttle()
 {
-    if (!managed_vm)
-        return;
-
-    if (!crawl_state.throttle)
-        return;
-
-    if (throttle_unit_lines <= 0)
-        throttle_unit_lines = 500;
+    const bool throttled = managed_vm && crawl_state.throttle;
+    if (throttled)
+    {
+        if (throttle_unit_lines <= 0)
+            throttle_unit_lines = 500;
 
-    if (throttle_sleep_start < 1)
-        throttle_sleep_start = 1;
+        if (throttle_sleep_start < 1)
+            throttle_sleep_start = 1;
 
-    if (throttle_sleep_end < throttle_sleep_start)
-        throttle_sleep_end = throttle_sleep_start;
+        if (throttle_sleep_end < throttle_sleep_start)
+            throttle_sleep_end = throttle_sleep_start;
+    }
 
     if (!mixed_call_depth)
     {
-        lua_sethook(_state, _clua_throttle_hook,
-                    LUA_MASKCOUNT, throttle_unit_lines);
+        int mask = throttled ? LUA_MASKCOUNT : 0;
+        if (lua_prof_enabled)
+            mask |= LUA_MASKCALL | LUA_MASKRET;
+        lua_sethook(_state, mask ? _clua_hook : nullptr, mask,
+                    throttle_unit_lines);
         throttle_sleep_ms = 0;
         n_throttle_sleeps = 0;
     }
@@ -651,10 +665,18 @@ void CLua::pushglobal(const string &name)
             }
         }
     }
+
+    // Called from C, the function would otherwise be nameless.
+    if (lua_prof_enabled && lua_isfunction(ls, -1))
+        lua_prof_name_next(name);
 }
 
 bool CLua::callfn(const char *fn, const char *params, ...)
 {
+    trace_span span("lua", fn);
+    if (span.active())
+        span.set_detail(managed_vm ? "clua" : "dlua");
+
     error.clear();
     lua_State *ls = state();
     if (!ls)
@@ -684,6 +706,10 @@ bool CLua::callfn(const char *fn, const char *params, ...)
 
 bool CLua::callfn(const char *fn, int nargs, int nret)
 {
+    trace_span span("lua", fn ? fn : "lua function");
+    if (span.active())
+        span.set_detail(managed_vm ? "clua" : "dlua");
+
     error.clear();
     lua_State *ls = state();
     if (!ls)
@@ -1116,10 +1142,8 @@ static void *_clua_allocator(void *ud, void *ptr, size_t osize, size_t nsize)
 }
 #endif
 
-static void _clua_throttle_hook(lua_State *ls, lua_Debug *dbg)
+static void _clua_throttle_hook(lua_State *ls)
 {
-    UNUSED(dbg);
-
     CLua *lua = lua_call_throttle::find_clua(ls);
 
     // Co-routines can create a new Lua state; in such cases, we must
@@ -1147,6 +1171,14 @@ static void _clua_throttle_hook(lua_State *ls, lua_Debug *dbg)
     }
 }
 
+static void _clua_hook(lua_State *ls, lua_Debug *dbg)
+{
+    if (dbg->event == LUA_HOOKCOUNT)
+        _clua_throttle_hook(ls);
+    else
+        lua_prof_hook(ls, dbg);
+}
+
 lua_call_throttle::lua_call_throttle(CLua *_lua)
     : lua(_lua)
 {
@@ -1158,7 +1190,11 @@ lua_call_throttle::lua_call_throttle(CLua *_lua)
 lua_call_throttle::~lua_call_throttle()
 {
     if (!--lua->mixed_call_depth)
+    {
         lua_map.erase(lua->state());
+        if (lua_prof_enabled)
+            lua_prof_unwind(lua->state());
+    }
 }
 
 CLua *lua_call_throttle::find_clua(lua_State *ls)
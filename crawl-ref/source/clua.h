@@ -105,6 +105,7 @@ public:
     void save_persist();
     void load_persist();
     void gc();
+    size_t heap_bytes() const;
 
     void setglobal(const char *name);
     void getglobal(const char *name);
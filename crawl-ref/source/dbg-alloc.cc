@@ -0,0 +1,294 @@
+/**
+ * @file
+ * @brief Counting of heap allocations, and memory use by subsystem.
+**/
+
+#include "AppHdr.h"
+
+#include "dbg-alloc.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#ifdef UNIX
+# include <sys/resource.h>
+# include <unistd.h>
+#endif
+
+#include "chardump.h"
+#include "clua.h"
+#include "dlua.h"
+#include "files.h"
+#include "initfile.h"
+#include "message.h"
+#include "player.h"
+#include "stringutil.h"
+#include "syscalls.h"
+
+bool alloc_counting = false;
+
+static alloc_totals counted = { 0, 0 };
+
+static const char *alloc_tag_names[] =
+{
+    "other",
+    "map knowledge",
+    "props",
+    "vaults",
+    "travel cache",
+    "stashes",
+};
+COMPILE_CHECK(ARRAYSZ(alloc_tag_names) == NUM_ALLOC_TAGS);
+
+alloc_totals alloc_counted()
+{
+    return counted;
+}
+
+#ifdef DEBUG_ALLOC_TAGS
+alloc_tag alloc_current_tag = ALLOC_OTHER;
+
+struct alloc_tag_stats
+{
+    uint64_t live_bytes;
+    uint64_t live_blocks;
+    uint64_t total_bytes;
+    uint64_t total_blocks;
+};
+
+static alloc_tag_stats tag_stats[NUM_ALLOC_TAGS];
+
+// Every block starts with one of these. The padding keeps the caller's part as
+// aligned as malloc would have.
+union alloc_header
+{
+    struct
+    {
+        size_t size;
+        alloc_tag tag;
+    } info;
+    max_align_t align;
+};
+
+static void *_malloc_or_throw(size_t size)
+{
+    while (true)
+    {
+        if (void *ptr = malloc(size ? size : 1))
+            return ptr;
+
+        new_handler handler = get_new_handler();
+        if (!handler)
+            throw bad_alloc();
+        handler();
+    }
+}
+
+// The replaceable global allocation functions. The array forms come through
+// here by default; the nothrow forms are replaced too, since older standard
+// libraries implement them with malloc rather than with these.
+void *operator new(size_t size)
+{
+    if (alloc_counting)
+    {
+        ++counted.count;
+        counted.bytes += size;
+    }
+
+    alloc_header *head = static_cast<alloc_header *>(
+        _malloc_or_throw(sizeof(alloc_header) + size));
+    head->info.size = size;
+    head->info.tag = alloc_current_tag;
+
+    alloc_tag_stats &stats = tag_stats[alloc_current_tag];
+    stats.live_bytes += size;
+    ++stats.live_blocks;
+    stats.total_bytes += size;
+    ++stats.total_blocks;
+    return head + 1;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr)
+    {
+        alloc_header *head = static_cast<alloc_header *>(ptr) - 1;
+        alloc_tag_stats &stats = tag_stats[head->info.tag];
+        stats.live_bytes -= head->info.size;
+        --stats.live_blocks;
+        ptr = head;
+    }
+    free(ptr);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (const bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr, const nothrow_t &) noexcept
+{
+    operator delete(ptr);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete[](void *ptr, const nothrow_t &) noexcept
+{
+    operator delete(ptr);
+}
+#endif
+
+// The resident set size and its peak so far in KiB, or -1 where the system
+// doesn't say.
+static void _resident_kib(long &current, long &peak)
+{
+    current = peak = -1;
+#ifdef TARGET_OS_LINUX
+    if (FILE *statm = fopen("/proc/self/statm", "r"))
+    {
+        long size, resident;
+        if (fscanf(statm, "%ld %ld", &size, &resident) == 2)
+            current = resident * (sysconf(_SC_PAGESIZE) / 1024);
+        fclose(statm);
+    }
+#endif
+#ifdef UNIX
+    struct rusage usage;
+    if (!getrusage(RUSAGE_SELF, &usage))
+    {
+# ifdef TARGET_OS_MACOSX
+        peak = usage.ru_maxrss / 1024; // in bytes, unlike everywhere else
+# else
+        peak = usage.ru_maxrss;
+# endif
+    }
+#endif
+}
+
+static string _kib(long kib)
+{
+    return kib < 0 ? string("?") : make_stringf("%ld", kib);
+}
+
+/**
+ * Summarise the memory in use: the process as a whole, the Lua interpreters,
+ * and in builds with DEBUG_ALLOC_TAGS, the heap of each subsystem.
+ */
+vector<string> alloc_report()
+{
+    vector<string> lines;
+
+    long resident, peak;
+    _resident_kib(resident, peak);
+    lines.push_back(make_stringf("Resident: %s KiB (peak %s KiB)",
+                                 _kib(resident).c_str(), _kib(peak).c_str()));
+    lines.push_back(make_stringf("Lua heaps: clua %u KiB, dlua %u KiB",
+                                 (unsigned int) (clua.heap_bytes() / 1024),
+                                 (unsigned int) (dlua.heap_bytes() / 1024)));
+
+#ifndef DEBUG_ALLOC_TAGS
+    lines.push_back("Build with ALLOC_TAGS=y to break down the heap by "
+                    "subsystem.");
+#else
+    lines.push_back(make_stringf("%-14s %10s %10s %14s %12s", "Subsystem",
+                                 "Live KiB", "Blocks", "Allocated KiB",
+                                 "Allocations"));
+    alloc_tag_stats total = { 0, 0, 0, 0 };
+    for (int i = 0; i < NUM_ALLOC_TAGS; i++)
+    {
+        const alloc_tag_stats &stats = tag_stats[i];
+        lines.push_back(make_stringf(
+            "%-14s %10" PRIu64 " %10" PRIu64 " %14" PRIu64 " %12" PRIu64,
+            alloc_tag_names[i], stats.live_bytes / 1024, stats.live_blocks,
+            stats.total_bytes / 1024, stats.total_blocks));
+        total.live_bytes += stats.live_bytes;
+        total.live_blocks += stats.live_blocks;
+        total.total_bytes += stats.total_bytes;
+        total.total_blocks += stats.total_blocks;
+    }
+    lines.push_back(make_stringf(
+        "%-14s %10" PRIu64 " %10" PRIu64 " %14" PRIu64 " %12" PRIu64,
+        "total", total.live_bytes / 1024, total.live_blocks,
+        total.total_bytes / 1024, total.total_blocks));
+#endif
+    return lines;
+}
+
+static string _memory_file(const char *kind)
+{
+    return morgue_directory() + kind + "-"
+           + strip_filename_unsafe_chars(you.your_name) + ".txt";
+}
+
+/**
+ * Append one line of live heap sizes to memory-log-<name>.txt in the morgue
+ * directory. Called every mem_sample_turns turns.
+ */
+void alloc_sample()
+{
+    static bool header_written = false;
+    FILE *f = fopen_u(_memory_file("memory-log").c_str(), "a");
+    if (!f)
+        return;
+
+    if (!header_written)
+    {
+        fprintf(f, "turn\tplace\tresident_kib\tclua_kib\tdlua_kib");
+#ifdef DEBUG_ALLOC_TAGS
+        for (const char *name : alloc_tag_names)
+            fprintf(f, "\t%s_kib", replace_all(name, " ", "_").c_str());
+#endif
+        fprintf(f, "\n");
+        header_written = true;
+    }
+
+    long resident, peak;
+    _resident_kib(resident, peak);
+    fprintf(f, "%d\t%s\t%s\t%u\t%u", you.num_turns,
+            level_id::current().describe().c_str(), _kib(resident).c_str(),
+            (unsigned int) (clua.heap_bytes() / 1024),
+            (unsigned int) (dlua.heap_bytes() / 1024));
+#ifdef DEBUG_ALLOC_TAGS
+    for (const alloc_tag_stats &stats : tag_stats)
+        fprintf(f, "\t%" PRIu64, stats.live_bytes / 1024);
+#endif
+    fprintf(f, "\n");
+    fclose(f);
+}
+
+/**
+ * Write the report to memory-<name>.txt in the morgue directory, if asked
+ * for with -mem-report. Called at exit.
+ */
+void alloc_dump()
+{
+    if (!SysEnv.mem_report)
+        return;
+
+    FILE *f = fopen_replace(_memory_file("memory").c_str());
+    if (!f)
+        return;
+    for (const string &line : alloc_report())
+        fprintf(f, "%s\n", line.c_str());
+    fclose(f);
+}
+
+#ifdef WIZARD
+void debug_memory_report()
+{
+    for (const string &line : alloc_report())
+        mprf("%s", line.c_str());
+}
+#endif
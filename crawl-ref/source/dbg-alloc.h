@@ -0,0 +1,76 @@
+/**
+ * @file
+ * @brief Counting of heap allocations, and memory use by subsystem.
+**/
+
+#pragma once
+
+// Whether operator new counts what it allocates. Off by default; turning it
+// on costs a flag test and two additions per allocation. Only builds with
+// DEBUG_ALLOC_TAGS count anything.
+extern bool alloc_counting;
+
+struct alloc_totals
+{
+    uint64_t count;
+    uint64_t bytes;
+};
+
+alloc_totals alloc_counted();
+
+// The subsystems whose heap use can be told apart. Be sure to change
+// alloc_tag_names in dbg-alloc.cc to match.
+enum alloc_tag
+{
+    ALLOC_OTHER,
+    ALLOC_MAP_KNOWLEDGE,    // monster_info, item_info and cloud_info in map_cells
+    ALLOC_PROPS,            // CrawlHashTable and CrawlVector contents
+    ALLOC_VAULTS,           // vault definitions
+    ALLOC_TRAVEL_CACHE,
+    ALLOC_STASHES,
+    NUM_ALLOC_TAGS
+};
+
+vector<string> alloc_report();
+void alloc_sample();
+void alloc_dump();
+#ifdef WIZARD
+void debug_memory_report();
+#endif
+
+#ifdef DEBUG_ALLOC_TAGS
+// The subsystem that allocations are charged to; see alloc_scope.
+extern alloc_tag alloc_current_tag;
+
+/**
+ * Charges the allocations made in the scope it lives in to a subsystem.
+ * Memory is charged when allocated, and credited back to the same subsystem
+ * when freed, wherever that happens.
+ *
+ * Charging needs a build with DEBUG_ALLOC_TAGS, which replaces the global
+ * operator new and delete to store the size and subsystem of every block.
+ * Otherwise a scope is empty and compiles to nothing.
+ */
+class alloc_scope
+{
+public:
+    explicit alloc_scope(alloc_tag tag) : prev(alloc_current_tag)
+    {
+        alloc_current_tag = tag;
+    }
+
+    ~alloc_scope()
+    {
+        alloc_current_tag = prev;
+    }
+
+private:
+    alloc_tag prev;
+};
+#else
+class alloc_scope
+{
+public:
+    explicit alloc_scope(alloc_tag) { }
+};
+#endif
@@ -0,0 +1,293 @@
+/**
+ * @file
+ * @brief Timing of the Lua functions that clua and dlua call.
+ *
+ * With profiling on, every Lua state gets a call and return hook, which
+ * counts the calls of each function and times them. A function's total time
+ * includes the functions it calls and its self time doesn't. Functions are
+ * told apart by where they are defined, so each vault's chunks and each
+ * player's rc hooks get lines of their own.
+**/
+
+#include "AppHdr.h"
+
+#include "dbg-luaprof.h"
+
+#include <chrono>
+#include <cinttypes>
+
+#include "chardump.h"
+#include "clua.h"
+#include "files.h"
+#include "initfile.h"
+#include "message.h"
+#include "player.h"
+#include "prompt.h"
+#include "stringutil.h"
+
+typedef chrono::steady_clock lua_prof_clock;
+
+bool lua_prof_enabled = false;
+
+struct lua_fn_stats
+{
+    string name;
+    uint64_t calls;
+    uint64_t total_ns;
+    uint64_t self_ns;
+};
+
+struct lua_prof_frame
+{
+    lua_fn_stats *fn;
+    int depth;
+    lua_prof_clock::time_point start;
+    uint64_t child_ns;
+};
+
+struct lua_prof_thread
+{
+    bool managed;
+    vector<lua_prof_frame> frames;
+};
+
+// Keyed by where each function is defined: clua's first, then dlua's.
+static map<string, lua_fn_stats> fn_stats[2];
+// The calls in progress in each Lua thread, including coroutines.
+static map<lua_State *, lua_prof_thread> threads;
+// What C code called the next function that Lua can't name.
+static string next_name;
+
+// How many functions the thread is running, counting the one being hooked.
+// Levels are found by bisection since lua_getstack walks the whole stack.
+static int _stack_depth(lua_State *ls)
+{
+    lua_Debug ar;
+    int found = 0, missing = 1;
+    while (lua_getstack(ls, missing, &ar))
+    {
+        found = missing;
+        missing *= 2;
+    }
+    while (missing - found > 1)
+    {
+        const int mid = (found + missing) / 2;
+        if (lua_getstack(ls, mid, &ar))
+            found = mid;
+        else
+            missing = mid;
+    }
+    return found + 1;
+}
+
+static lua_prof_thread &_thread(lua_State *ls)
+{
+    auto it = threads.find(ls);
+    if (it == threads.end())
+    {
+        it = threads.emplace(ls, lua_prof_thread()).first;
+        it->second.managed = CLua::is_managed_vm(ls);
+    }
+    return it->second;
+}
+
+// Finish the calls at depth or deeper, charging them up to now. Calls found
+// deeper than the one being hooked were cut short by an error, which Lua
+// doesn't tell the hook about.
+static void _return_to(lua_prof_thread &thread, int depth,
+                       lua_prof_clock::time_point now)
+{
+    while (!thread.frames.empty() && thread.frames.back().depth >= depth)
+    {
+        const lua_prof_frame frame = thread.frames.back();
+        thread.frames.pop_back();
+
+        const uint64_t ns = max<int64_t>(0,
+            chrono::duration_cast<chrono::nanoseconds>(now - frame.start)
+                .count());
+        frame.fn->total_ns += ns;
+        frame.fn->self_ns += ns - min(ns, frame.child_ns);
+        if (!thread.frames.empty())
+            thread.frames.back().child_ns += ns;
+    }
+}
+
+static lua_fn_stats &_fn_stats(bool managed, lua_Debug *ar)
+{
+    const char *name = ar->name;
+    if (!name && !next_name.empty())
+        name = next_name.c_str();
+
+    string where;
+    if (!strcmp(ar->what, "C"))
+        where = make_stringf("[C] %s", name ? name : "?");
+    else
+        where = make_stringf("%s:%d", ar->short_src, ar->linedefined);
+
+    lua_fn_stats &fn = fn_stats[managed ? 0 : 1][where];
+    if (fn.name.empty() || (name && fn.name[0] == '('))
+    {
+        if (!strcmp(ar->what, "C"))
+            fn.name = where;
+        else if (name)
+            fn.name = make_stringf("%s (%s)", name, where.c_str());
+        else if (!strcmp(ar->what, "main"))
+            fn.name = make_stringf("(chunk) (%s)", where.c_str());
+        else
+            fn.name = make_stringf("(anonymous) (%s)", where.c_str());
+    }
+    return fn;
+}
+
+/// The call and return hook of every Lua state, while profiling.
+void lua_prof_hook(lua_State *ls, lua_Debug *ar)
+{
+    const lua_prof_clock::time_point now = lua_prof_clock::now();
+    lua_prof_thread &thread = _thread(ls);
+    const int depth = _stack_depth(ls);
+
+    // Lua 5.1 calls the hook for a tail call before moving the call down
+    // over its caller, so a call's recorded depth can be one too deep. A
+    // return therefore finishes its own call and any tail-calling caller,
+    // and a new call only finishes calls deeper than itself.
+    if (ar->event != LUA_HOOKCALL)
+    {
+        _return_to(thread, depth, now);
+        // Forget finished coroutines, whose states Lua may reuse.
+        if (thread.frames.empty())
+            threads.erase(ls);
+        return;
+    }
+    _return_to(thread, depth + 1, now);
+
+    lua_getinfo(ls, "Sn", ar);
+    lua_fn_stats &fn = _fn_stats(thread.managed, ar);
+    next_name.clear();
+    ++fn.calls;
+    // Start the clock after the bookkeeping, to charge less of it.
+    thread.frames.push_back({ &fn, depth, lua_prof_clock::now(), 0 });
+}
+
+/**
+ * Name the next function called, if Lua can't: it only knows the names of
+ * functions called from Lua. Called when C code looks up a function by name.
+ */
+void lua_prof_name_next(const string &name)
+{
+    next_name = name;
+}
+
+/**
+ * Finish every call still open in a Lua state, once C code has no more calls
+ * into it in progress. Calls cut short by an error are finished here.
+ */
+void lua_prof_unwind(lua_State *ls)
+{
+    auto it = threads.find(ls);
+    if (it == threads.end())
+        return;
+    _return_to(it->second, 0, lua_prof_clock::now());
+    threads.erase(it);
+    next_name.clear();
+}
+
+void lua_prof_reset()
+{
+    for (auto &stats : fn_stats)
+        stats.clear();
+    threads.clear();
+    next_name.clear();
+}
+
+/**
+ * Summarise the calls of each interpreter, with the functions taking the
+ * most time first. Times other than totals are in microseconds.
+ *
+ * @param max_rows How many functions to list per interpreter; 0 for all.
+ */
+vector<string> lua_prof_report(int max_rows)
+{
+    static const char *vm_names[] = { "clua", "dlua" };
+
+    vector<string> lines;
+    for (int vm = 0; vm < 2; vm++)
+    {
+        vector<const lua_fn_stats *> fns;
+        uint64_t calls = 0;
+        for (const auto &entry : fn_stats[vm])
+        {
+            fns.push_back(&entry.second);
+            calls += entry.second.calls;
+        }
+        sort(fns.begin(), fns.end(),
+             [](const lua_fn_stats *a, const lua_fn_stats *b)
+             {
+                 return a->total_ns > b->total_ns;
+             });
+
+        if (!lines.empty())
+            lines.push_back("");
+        lines.push_back(make_stringf("%s: %" PRIu64 " calls of %u functions",
+                                     vm_names[vm], calls,
+                                     (unsigned int) fns.size()));
+        if (fns.empty())
+            continue;
+
+        lines.push_back(make_stringf("%9s %10s %10s %9s  %s", "Calls",
+                                     "Total ms", "Self ms", "Mean us",
+                                     "Function"));
+        for (int i = 0; i < (int) fns.size() && (!max_rows || i < max_rows);
+             i++)
+        {
+            const lua_fn_stats &fn = *fns[i];
+            lines.push_back(make_stringf(
+                "%9" PRIu64 " %10.2f %10.2f %9.1f  %s", fn.calls,
+                fn.total_ns / 1e6, fn.self_ns / 1e6,
+                fn.calls ? fn.total_ns / 1e3 / fn.calls : 0.0,
+                fn.name.c_str()));
+        }
+    }
+    return lines;
+}
+
+/**
+ * Write the report to lua-profile-<name>.txt in the morgue directory, if
+ * profiling with -lua-profile. Called at exit.
+ */
+void lua_prof_dump()
+{
+    if (!SysEnv.lua_profile)
+        return;
+
+    const string file_name = morgue_directory() + "lua-profile-"
+                             + strip_filename_unsafe_chars(you.your_name)
+                             + ".txt";
+    FILE *f = fopen_replace(file_name.c_str());
+    if (!f)
+        return;
+    for (const string &line : lua_prof_report())
+        fprintf(f, "%s\n", line.c_str());
+    fclose(f);
+}
+
+#ifdef WIZARD
+void debug_lua_profile()
+{
+    for (const string &line : lua_prof_report(20))
+        mprf("%s", line.c_str());
+
+    const char *prompt = lua_prof_enabled
+        ? "Stop profiling Lua?"
+        : "Start profiling Lua? This clears the calls so far.";
+    if (!yesno(prompt, true, 'n'))
+    {
+        canned_msg(MSG_OK);
+        return;
+    }
+
+    lua_prof_enabled = !lua_prof_enabled;
+    if (lua_prof_enabled)
+        lua_prof_reset();
+    mprf("Lua profiling is %s.", lua_prof_enabled ? "on" : "off");
+}
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file
+ * @brief Timing of the Lua functions that clua and dlua call.
+**/
+
+#pragma once
+
+struct lua_State;
+struct lua_Debug;
+
+// Whether the Lua hooks count and time calls; set by -lua-profile or &U.
+extern bool lua_prof_enabled;
+
+void lua_prof_hook(lua_State *ls, lua_Debug *ar);
+void lua_prof_name_next(const string &name);
+void lua_prof_unwind(lua_State *ls);
+void lua_prof_reset();
+vector<string> lua_prof_report(int max_rows = 0);
+void lua_prof_dump();
+#ifdef WIZARD
+void debug_lua_profile();
+#endif
@@ -7,6 +7,8 @@
 
 #include "dbg-maps.h"
 
+#include <cinttypes>
+
 #include "branch.h"
 #include "chardump.h"
 #include "crash.h"
@@ -18,11 +20,15 @@
 #include "maps.h"
 #include "message.h"
 #include "ng-init.h"
+#include "options.h"
 #include "player.h"
+#include "random.h"
 #include "shopping.h"
 #include "state.h"
 #include "stringutil.h"
+#include "syscalls.h"
 #include "tag-version.h"
+#include "tags.h"
 #include "view.h"
 
 #ifdef DEBUG_STATISTICS
@@ -47,10 +53,43 @@ static int build_attempts = 0, level_vetoes = 0;
 // Map from message to counts.
 static map<string, int> veto_messages;
 
+// Iteration i is built from seed iteration_seed + i.
+static uint64_t iteration_seed = 0;
+
+static const char *mapstat_timing_names[] =
+{
+    "builder",
+    "build attempt",
+    "vault placement",
+    "vault fitting",
+    "map Lua",
+    "connectivity",
+};
+COMPILE_CHECK(ARRAYSZ(mapstat_timing_names) == NUM_MAPSTAT_TIMINGS);
+
+struct mapstat_time
+{
+    int count;
+    uint64_t ns;
+};
+
+static mapstat_time timing_totals[NUM_MAPSTAT_TIMINGS];
+static int timing_depth[NUM_MAPSTAT_TIMINGS];
+// Time by map name, for the parts timed per map.
+static map<string, mapstat_time> map_times[NUM_MAPSTAT_TIMINGS];
+// Build attempts by layout map, and vetoed attempts by veto message.
+static map<string, mapstat_time> layout_times;
+static map<string, mapstat_time> veto_times;
+// The layout map and veto message of the attempt in progress, if any.
+static string attempt_layout;
+static string attempt_veto;
+
 void mapstat_report_map_build_start()
 {
     build_attempts++;
     map_builds[level_id::current()].first++;
+    attempt_layout.clear();
+    attempt_veto.clear();
 }
 
 void mapstat_report_map_veto(const string &message)
@@ -58,6 +97,49 @@ void mapstat_report_map_veto(const string &message)
     level_vetoes++;
     ++veto_messages[message];
     map_builds[level_id::current()].second++;
+    attempt_veto = message;
+}
+
+static void _add_time(mapstat_time &time, uint64_t ns)
+{
+    ++time.count;
+    time.ns += ns;
+}
+
+mapstat_timer::mapstat_timer(mapstat_timing what, const string &name)
+    : timing(what),
+      running(crawl_state.map_stat_gen && crawl_state.generating_level)
+{
+    if (!running)
+        return;
+
+    map_name = name;
+    ++timing_depth[timing];
+    start = chrono::steady_clock::now();
+}
+
+mapstat_timer::~mapstat_timer()
+{
+    if (!running)
+        return;
+
+    const uint64_t ns = max<int64_t>(0,
+        chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now() - start).count());
+
+    if (!--timing_depth[timing])
+        _add_time(timing_totals[timing], ns);
+    if (!map_name.empty())
+        _add_time(map_times[timing][map_name], ns);
+
+    if (timing == MST_ATTEMPT)
+    {
+        _add_time(layout_times[attempt_layout.empty() ? "(no layout map)"
+                                                      : attempt_layout],
+                  ns);
+        if (!attempt_veto.empty())
+            _add_time(veto_times[attempt_veto], ns);
+    }
 }
 
 static bool _is_disconnected_level()
@@ -231,25 +313,22 @@ static bool _build_dungeon()
 }
 
 /**
- * Build dungeon levels for mapstat or objstat.
- *
- * The exact branches/levels built and number of build iterations is set by the
- * command-line options for mapstat/objstat.
+ * Put everything the builder remembers between levels back into its new-game
+ * state and reseed, so that what an iteration builds depends only on its
+ * number and the base seed, not on the iterations before it.
+ */
+static void _reset_iteration(int iter)
+{
+    rng::seed(iteration_seed + iter);
+    dgn_flush_map_memory();
+    initialise_item_descriptions();
+    initialise_branch_depths();
+    init_level_connectivity();
+}
 
- * @returns True if all iterations built successfully. For mapstat, this can
- * return false if an iteration produced a disconnected level, since for
- * diagnostic purposes we record the map in detail to a file and exit. For
- * objstat, this only returns false if the primary dungeon generation function
- * builder() fails, as the level may be in an invalid state and any object
- * statistics erroneous.
-*/
-bool mapstat_build_levels()
+static bool _build_iterations(int first, int last)
 {
-    if (!generated_levels.size())
-        _dungeon_places();
-    printf("Iteration: ");
-    fflush(stdout);
-    for (int i = 0; i < SysEnv.map_gen_iters; ++i)
+    for (int i = first; i < last; ++i)
     {
         clear_messages();
         mprf("On %d of %d; %d g, %d fail, %u err%s, %u uniq, "
@@ -261,19 +340,262 @@ bool mapstat_build_levels()
              build_attempts ? level_vetoes * 100.0 / build_attempts : 0.0);
         printf("%d..", i + 1);
         fflush(stdout);
-        dlua.callfn("dgn_clear_data", "");
-        you.uniq_map_tags.clear();
-        you.uniq_map_names.clear();
-        you.uniq_map_tags_abyss.clear();
-        you.uniq_map_names_abyss.clear();
-        you.unique_creatures.reset();
-        initialise_branch_depths();
-        init_level_connectivity();
+        _reset_iteration(i);
         if (!_build_dungeon())
             return false;
         if (crawl_state.obj_stat_gen)
             objstat_iteration_stats();
     }
+    return true;
+}
+
+#ifndef TARGET_OS_WINDOWS
+static void _marshall_counts(writer &th, const map<string, int> &counts)
+{
+    marshallUnsigned(th, counts.size());
+    for (const auto &entry : counts)
+    {
+        marshallString(th, entry.first);
+        marshallSigned(th, entry.second);
+    }
+}
+
+static void _merge_counts(reader &th, map<string, int> &counts)
+{
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        const string name = unmarshallString(th);
+        counts[name] += unmarshallSigned(th);
+    }
+}
+
+static void _marshall_times(writer &th, const map<string, mapstat_time> &times)
+{
+    marshallUnsigned(th, times.size());
+    for (const auto &entry : times)
+    {
+        marshallString(th, entry.first);
+        marshallSigned(th, entry.second.count);
+        marshallUnsigned(th, entry.second.ns);
+    }
+}
+
+static void _merge_times(reader &th, map<string, mapstat_time> &times)
+{
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        mapstat_time &time = times[unmarshallString(th)];
+        time.count += unmarshallSigned(th);
+        time.ns += unmarshallUnsigned(th);
+    }
+}
+
+/// Write everything a stat worker has counted, for _merge_map_stats().
+static void _marshall_map_stats(writer &th)
+{
+    _marshall_counts(th, try_count);
+    _marshall_counts(th, use_count);
+    _marshall_counts(th, success_count);
+    _marshall_counts(th, veto_messages);
+
+    marshallUnsigned(th, level_mapcounts.size());
+    for (const auto &entry : level_mapcounts)
+    {
+        marshall_level_id(th, entry.first);
+        marshallSigned(th, entry.second);
+    }
+
+    marshallUnsigned(th, map_builds.size());
+    for (const auto &entry : map_builds)
+    {
+        marshall_level_id(th, entry.first);
+        marshallSigned(th, entry.second.first);
+        marshallSigned(th, entry.second.second);
+    }
+
+    marshallUnsigned(th, level_mapsused.size());
+    for (const auto &entry : level_mapsused)
+    {
+        marshall_level_id(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const string &name : entry.second)
+            marshallString(th, name);
+    }
+
+    marshallUnsigned(th, map_levelsused.size());
+    for (const auto &entry : map_levelsused)
+    {
+        marshallString(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const level_id &lid : entry.second)
+            marshall_level_id(th, lid);
+    }
+
+    marshallUnsigned(th, errors.size());
+    for (const auto &entry : errors)
+    {
+        marshallString(th, entry.first);
+        marshallString(th, entry.second);
+    }
+    marshallString(th, last_error);
+
+    marshallSigned(th, levels_tried);
+    marshallSigned(th, levels_failed);
+    marshallSigned(th, build_attempts);
+    marshallSigned(th, level_vetoes);
+
+    for (int i = 0; i < NUM_MAPSTAT_TIMINGS; ++i)
+    {
+        marshallSigned(th, timing_totals[i].count);
+        marshallUnsigned(th, timing_totals[i].ns);
+        _marshall_times(th, map_times[i]);
+    }
+    _marshall_times(th, layout_times);
+    _marshall_times(th, veto_times);
+}
+
+/// Add a stat worker's counts, as written by _marshall_map_stats(), to ours.
+static void _merge_map_stats(reader &th)
+{
+    _merge_counts(th, try_count);
+    _merge_counts(th, use_count);
+    _merge_counts(th, success_count);
+    _merge_counts(th, veto_messages);
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        const level_id lid = unmarshall_level_id(th);
+        level_mapcounts[lid] += unmarshallSigned(th);
+    }
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        const level_id lid = unmarshall_level_id(th);
+        const int builds = unmarshallSigned(th);
+        map_builds[lid].first += builds;
+        map_builds[lid].second += unmarshallSigned(th);
+    }
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        set<string> &maps = level_mapsused[unmarshall_level_id(th)];
+        for (uint64_t m = unmarshallUnsigned(th); m; --m)
+            maps.insert(unmarshallString(th));
+    }
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        set<level_id> &levels = map_levelsused[unmarshallString(th)];
+        for (uint64_t m = unmarshallUnsigned(th); m; --m)
+            levels.insert(unmarshall_level_id(th));
+    }
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        const string name = unmarshallString(th);
+        errors[name] = unmarshallString(th);
+    }
+    const string error = unmarshallString(th);
+    if (!error.empty())
+        last_error = error;
+
+    levels_tried += unmarshallSigned(th);
+    levels_failed += unmarshallSigned(th);
+    build_attempts += unmarshallSigned(th);
+    level_vetoes += unmarshallSigned(th);
+
+    for (int i = 0; i < NUM_MAPSTAT_TIMINGS; ++i)
+    {
+        timing_totals[i].count += unmarshallSigned(th);
+        timing_totals[i].ns += unmarshallUnsigned(th);
+        _merge_times(th, map_times[i]);
+    }
+    _merge_times(th, layout_times);
+    _merge_times(th, veto_times);
+}
+
+/**
+ * Split the iterations into contiguous ranges and build each range in a
+ * forked worker. Workers send their counters back when they are done, and we
+ * add them up here in worker order. Since every iteration is seeded on its
+ * own, the totals are the same as those of a serial run.
+ */
+static bool _build_iterations_parallel(int jobs)
+{
+    const auto results = run_forked_jobs(jobs, [jobs](int job) {
+        const int first = SysEnv.map_gen_iters * job / jobs;
+        const int last = SysEnv.map_gen_iters * (job + 1) / jobs;
+        const bool built = _build_iterations(first, last);
+
+        vector<unsigned char> buf;
+        writer th(&buf);
+        marshallBoolean(th, built);
+        _marshall_map_stats(th);
+        if (crawl_state.obj_stat_gen)
+            objstat_marshall_stats(th);
+        return buf;
+    });
+
+    bool built = true;
+    for (int job = 0; job < jobs; ++job)
+    {
+        if (results[job].empty())
+        {
+            fprintf(stderr, "Stat worker %d of %d failed.\n", job + 1, jobs);
+            built = false;
+            continue;
+        }
+
+        reader th(results[job]);
+        if (!unmarshallBoolean(th))
+            built = false;
+        _merge_map_stats(th);
+        if (crawl_state.obj_stat_gen)
+            objstat_merge_stats(th);
+    }
+    return built;
+}
+#endif
+
+/**
+ * Build dungeon levels for mapstat or objstat.
+ *
+ * The exact branches/levels built and number of build iterations is set by the
+ * command-line options for mapstat/objstat. With -stat-jobs, the iterations
+ * are split over that many worker processes.
+
+ * @returns True if all iterations built successfully. For mapstat, this can
+ * return false if an iteration produced a disconnected level, since for
+ * diagnostic purposes we record the map in detail to a file and exit. For
+ * objstat, this only returns false if the primary dungeon generation function
+ * builder() fails, as the level may be in an invalid state and any object
+ * statistics erroneous.
+*/
+bool mapstat_build_levels()
+{
+    if (!generated_levels.size())
+        _dungeon_places();
+
+    if (!iteration_seed)
+    {
+        iteration_seed = Options.seed;
+        while (!iteration_seed) // 0 = random seed
+            iteration_seed = rng::get_uint64();
+        printf("Seed: %" PRIu64 "\n", iteration_seed);
+    }
+
+    printf("Iteration: ");
+    fflush(stdout);
+    bool built;
+#ifndef TARGET_OS_WINDOWS
+    const int jobs = min(SysEnv.map_gen_jobs, SysEnv.map_gen_iters);
+    if (jobs > 1)
+        built = _build_iterations_parallel(jobs);
+    else
+#endif
+        built = _build_iterations(0, SysEnv.map_gen_iters);
+    if (!built)
+        return false;
     printf("Finished.\n");
     fflush(stdout);
     return true;
@@ -286,6 +608,8 @@ void mapstat_report_map_try(const map_def &map)
 
 void mapstat_report_map_use(const map_def &map)
 {
+    if (attempt_layout.empty() && map.is_overwritable_layout())
+        attempt_layout = map.name;
     use_count[map.name]++;
     level_mapcounts[level_id::current()]++;
     level_mapsused[level_id::current()].insert(map.name);
@@ -331,6 +655,84 @@ static void _check_mapless(const level_id &lid, vector<level_id> &mapless)
         mapless.push_back(lid);
 }
 
+static double _ms(uint64_t ns)
+{
+    return ns / 1e6;
+}
+
+static void _write_timed(FILE *outf, const map<string, mapstat_time> &times)
+{
+    multimap<uint64_t, string> sorted;
+    for (const auto &entry : times)
+        sorted.insert(make_pair(entry.second.ns, entry.first));
+
+    fprintf(outf, "%8s %12s %10s  %s\n", "Count", "Total ms", "Mean ms",
+            "Name");
+    for (auto i = sorted.rbegin(); i != sorted.rend(); ++i)
+    {
+        const mapstat_time &time = times.at(i->second);
+        fprintf(outf, "%8d %12.1f %10.3f  %s\n", time.count, _ms(time.ns),
+                _ms(time.ns) / time.count, i->second.c_str());
+    }
+}
+
+// Where the builder's time went, by part, layout, veto and map. Times
+// include whatever is nested in them: a map's placement includes its Lua,
+// and may include placing its subvaults.
+static void _write_builder_times(FILE *outf)
+{
+    fprintf(outf, "\n\nBuilder time:\n\n");
+    fprintf(outf, "%-16s %8s %12s %10s\n", "Part", "Count", "Total ms",
+            "Mean ms");
+    for (int i = 0; i < NUM_MAPSTAT_TIMINGS; ++i)
+    {
+        const mapstat_time &time = timing_totals[i];
+        fprintf(outf, "%-16s %8d %12.1f %10.3f\n", mapstat_timing_names[i],
+                time.count, _ms(time.ns),
+                time.count ? _ms(time.ns) / time.count : 0.0);
+    }
+
+    fprintf(outf, "\n\nBuild attempt time by layout:\n\n");
+    _write_timed(outf, layout_times);
+
+    if (!veto_times.empty())
+    {
+        fprintf(outf, "\n\nVetoed build attempt time by veto reason:\n\n");
+        _write_timed(outf, veto_times);
+    }
+
+    fprintf(outf, "\n\nMap time (placing, fitting, Lua), by placing time:"
+                  "\n\n");
+    fprintf(outf, "%8s %12s %12s %12s %10s  %s\n", "Tries", "Place ms",
+            "Fit ms", "Lua ms", "Mean ms", "Map");
+    set<string> names;
+    for (int i : { MST_VAULT, MST_VAULT_FIT, MST_MAP_LUA })
+        for (const auto &entry : map_times[i])
+            names.insert(entry.first);
+
+    multimap<pair<uint64_t, uint64_t>, string> sorted;
+    for (const string &name : names)
+    {
+        sorted.insert(make_pair(
+            make_pair(lookup(map_times[MST_VAULT], name, mapstat_time()).ns,
+                      lookup(map_times[MST_MAP_LUA], name, mapstat_time()).ns),
+            name));
+    }
+    for (auto i = sorted.rbegin(); i != sorted.rend(); ++i)
+    {
+        const mapstat_time place =
+            lookup(map_times[MST_VAULT], i->second, mapstat_time());
+        const mapstat_time fit =
+            lookup(map_times[MST_VAULT_FIT], i->second, mapstat_time());
+        const mapstat_time lua =
+            lookup(map_times[MST_MAP_LUA], i->second, mapstat_time());
+        fprintf(outf, "%8d %12.1f %12.1f %12.1f %10.3f  %s\n", place.count,
+                _ms(place.ns), _ms(fit.ns), _ms(lua.ns),
+                place.count ? _ms(place.ns) / place.count : 0.0,
+                i->second.c_str());
+    }
+}
+
 static void _write_map_stats()
 {
     const char *out_file = "mapstat.log";
@@ -417,6 +819,8 @@ static void _write_map_stats()
             fprintf(outf, "%3d) %s\n", i->first, i->second.c_str());
     }
 
+    _write_builder_times(outf);
+
     if (!unused_maps.empty() && !SysEnv.map_gen_range)
     {
         fprintf(outf, "\n\nUnused maps:\n\n");
@@ -7,6 +7,8 @@
 
 #ifdef DEBUG_STATISTICS
 
+#include <chrono>
+
 class map_def;
 void mapstat_report_map_try(const map_def &map);
 void mapstat_report_map_use(const map_def &map);
@@ -17,4 +19,36 @@ void mapstat_report_map_veto(const string &message);
 void mapstat_generate_stats();
 bool mapstat_build_levels();
 bool mapstat_find_forced_map();
+
+// The parts of the builder that mapstat times. Be sure to change
+// mapstat_timing_names in dbg-maps.cc to match.
+enum mapstat_timing
+{
+    MST_BUILDER,        // builder(), all attempts at a level
+    MST_ATTEMPT,        // _build_level_vetoable()
+    MST_VAULT,          // vault_main(), placing one map
+    MST_VAULT_FIT,      // _apply_vault_grid(), finding where it goes
+    MST_MAP_LUA,        // a map's Lua chunks and hooks
+    MST_CONNECTIVITY,   // checking the level is connected
+    NUM_MAPSTAT_TIMINGS
+};
+
+/**
+ * Times the scope it lives in towards a part of the builder, and towards a
+ * map if named, when generating map stats; maps loaded and checked outside
+ * the builder aren't timed. Only the outermost of nested timers of a part
+ * adds to its total, but every timer adds to its map's.
+ */
+class mapstat_timer
+{
+public:
+    explicit mapstat_timer(mapstat_timing what, const string &name = "");
+    ~mapstat_timer();
+
+private:
+    mapstat_timing timing;
+    string map_name;
+    bool running;
+    chrono::steady_clock::time_point start;
+};
 #endif
@@ -36,6 +36,7 @@
 #include "stepdown.h"
 #include "stringutil.h"
 #include "tag-version.h"
+#include "tags.h"
 #include "version.h"
 
 #ifdef DEBUG_STATISTICS
@@ -879,6 +880,216 @@ void objstat_iteration_stats()
     }
 }
 
+// Summary levels have depth -1 (and the all-levels one an invalid branch),
+// so don't squeeze these through marshall_level_id().
+static void _marshall_stat_level(writer &th, const level_id &lev)
+{
+    marshallSigned(th, lev.branch);
+    marshallSigned(th, lev.depth);
+}
+
+static level_id _unmarshall_stat_level(reader &th)
+{
+    const branch_type br = static_cast<branch_type>(unmarshallSigned(th));
+    const int depth = unmarshallSigned(th);
+    return level_id(br, depth);
+}
+
+static void _marshall_stats(writer &th, const map<string, double> &stats)
+{
+    marshallUnsigned(th, stats.size());
+    for (const auto &entry : stats)
+    {
+        marshallString(th, entry.first);
+        // Every value is a whole number or one of the INFINITY/-1 starting
+        // points for NumMin/NumMax, so the raw bits are exact.
+        th.write(&entry.second, sizeof(entry.second));
+    }
+}
+
+static void _merge_stats(reader &th, map<string, double> &stats)
+{
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        const string field = unmarshallString(th);
+        double value;
+        th.read(&value, sizeof(value));
+
+        double &total = stats[field];
+        if (field == "NumMin" || field == "AllNumMin")
+            total = min(total, value);
+        else if (field == "NumMax" || field == "AllNumMax")
+            total = max(total, value);
+        else
+            total += value;
+    }
+}
+
+static void _marshall_brands(writer &th, const vector<int> &brands)
+{
+    marshallUnsigned(th, brands.size());
+    for (int count : brands)
+        marshallSigned(th, count);
+}
+
+static void _merge_brands(reader &th, vector<int> &brands)
+{
+    const size_t size = unmarshallUnsigned(th);
+    if (brands.size() < size)
+        brands.resize(size, 0);
+    for (size_t i = 0; i < size; ++i)
+        brands[i] += unmarshallSigned(th);
+}
+
+static void _marshall_equip_brands(writer &th, const brand_records &records)
+{
+    marshallUnsigned(th, records.size());
+    for (const auto &entry : records)
+    {
+        _marshall_stat_level(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const auto &antiquities : entry.second)
+        {
+            marshallUnsigned(th, antiquities.size());
+            for (const auto &brands : antiquities)
+                _marshall_brands(th, brands);
+        }
+    }
+}
+
+static void _merge_equip_brands(reader &th, brand_records &records)
+{
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        auto &types = records[_unmarshall_stat_level(th)];
+        const size_t num_types = unmarshallUnsigned(th);
+        if (types.size() < num_types)
+            types.resize(num_types);
+        for (size_t i = 0; i < num_types; ++i)
+        {
+            const size_t num_antiq = unmarshallUnsigned(th);
+            if (types[i].size() < num_antiq)
+                types[i].resize(num_antiq);
+            for (size_t j = 0; j < num_antiq; ++j)
+                _merge_brands(th, types[i][j]);
+        }
+    }
+}
+
+/**
+ * Write all the statistics gathered so far, for a -stat-jobs worker to hand
+ * back to the parent process.
+ */
+void objstat_marshall_stats(writer &th)
+{
+    marshallUnsigned(th, item_recs.size());
+    for (const auto &entry : item_recs)
+    {
+        _marshall_stat_level(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const auto &subtypes : entry.second)
+        {
+            marshallUnsigned(th, subtypes.size());
+            for (const auto &stats : subtypes)
+                _marshall_stats(th, stats);
+        }
+    }
+
+    _marshall_equip_brands(th, weapon_brands);
+    _marshall_equip_brands(th, armour_brands);
+
+    marshallUnsigned(th, missile_brands.size());
+    for (const auto &entry : missile_brands)
+    {
+        _marshall_stat_level(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const auto &brands : entry.second)
+            _marshall_brands(th, brands);
+    }
+
+    marshallUnsigned(th, monster_recs.size());
+    for (const auto &entry : monster_recs)
+    {
+        _marshall_stat_level(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const auto &mentry : entry.second)
+        {
+            marshallSigned(th, mentry.first);
+            _marshall_stats(th, mentry.second);
+        }
+    }
+
+    marshallUnsigned(th, feature_recs.size());
+    for (const auto &entry : feature_recs)
+    {
+        _marshall_stat_level(th, entry.first);
+        marshallUnsigned(th, entry.second.size());
+        for (const auto &fentry : entry.second)
+        {
+            marshallSigned(th, fentry.first);
+            _marshall_stats(th, fentry.second);
+        }
+    }
+}
+
+/**
+ * Combine statistics written by objstat_marshall_stats() with our own, as if
+ * the worker's iterations had been run here. Counts and sums of squares add;
+ * per-iteration minima and maxima combine as such.
+ */
+void objstat_merge_stats(reader &th)
+{
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        auto &types = item_recs[_unmarshall_stat_level(th)];
+        const size_t num_types = unmarshallUnsigned(th);
+        if (types.size() < num_types)
+            types.resize(num_types);
+        for (size_t i = 0; i < num_types; ++i)
+        {
+            const size_t num_subtypes = unmarshallUnsigned(th);
+            if (types[i].size() < num_subtypes)
+                types[i].resize(num_subtypes);
+            for (size_t j = 0; j < num_subtypes; ++j)
+                _merge_stats(th, types[i][j]);
+        }
+    }
+
+    _merge_equip_brands(th, weapon_brands);
+    _merge_equip_brands(th, armour_brands);
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        auto &types = missile_brands[_unmarshall_stat_level(th)];
+        const size_t num_types = unmarshallUnsigned(th);
+        if (types.size() < num_types)
+            types.resize(num_types);
+        for (size_t i = 0; i < num_types; ++i)
+            _merge_brands(th, types[i]);
+    }
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        auto &monsters = monster_recs[_unmarshall_stat_level(th)];
+        for (uint64_t m = unmarshallUnsigned(th); m; --m)
+        {
+            const int mons_ind = unmarshallSigned(th);
+            _merge_stats(th, monsters[mons_ind]);
+        }
+    }
+
+    for (uint64_t n = unmarshallUnsigned(th); n; --n)
+    {
+        auto &features = feature_recs[_unmarshall_stat_level(th)];
+        for (uint64_t m = unmarshallUnsigned(th); m; --m)
+        {
+            const auto feat = static_cast<dungeon_feature_type>(
+                                  unmarshallSigned(th));
+            _merge_stats(th, features[feat]);
+        }
+    }
+}
+
 static void _write_stat_headers(const vector<string> &fields, string desc)
 {
     fprintf(stat_outf, "%s\tLevel", desc.c_str());
@@ -0,0 +1,188 @@
+/**
+ * @file
+ * @brief Timers for the phases of a game turn.
+**/
+
+#include "AppHdr.h"
+
+#include "dbg-prof.h"
+
+#include <cinttypes>
+
+#include "chardump.h"
+#include "files.h"
+#include "message.h"
+#include "player.h"
+#include "prompt.h"
+#include "stringutil.h"
+
+bool prof_enabled = false;
+
+static const char *phase_names[] =
+{
+    "world_reacts",
+    "handle_monsters",
+    "monster move",
+    "manage_clouds",
+    "apply_noises",
+    "LOS",
+    "viewwindow",
+    "update_level",
+    "send_map",
+};
+COMPILE_CHECK(ARRAYSZ(phase_names) == NUM_PROF_PHASES);
+
+// Samples are counted in log-linear buckets: each of the first
+// PROF_SUB_BUCKETS nanoseconds has its own bucket, and above that every power
+// of two is split into PROF_SUB_BUCKETS buckets, so percentiles are accurate
+// to within 1/PROF_SUB_BUCKETS.
+#define PROF_SUB_BITS 3
+#define PROF_SUB_BUCKETS (1 << PROF_SUB_BITS)
+// Enough for samples of up to 2^40ns, about eighteen minutes.
+#define PROF_BUCKETS ((40 - PROF_SUB_BITS + 1) * PROF_SUB_BUCKETS)
+
+struct prof_histogram
+{
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint32_t buckets[PROF_BUCKETS];
+};
+
+static prof_histogram histograms[NUM_PROF_PHASES];
+
+static int _bucket(uint64_t ns)
+{
+    if (ns < PROF_SUB_BUCKETS)
+        return ns;
+
+    // ns is in [2^octave, 2^(octave+1)).
+    int octave = PROF_SUB_BITS;
+    while (ns >> (octave + 1))
+        ++octave;
+    const int sub = (ns >> (octave - PROF_SUB_BITS)) & (PROF_SUB_BUCKETS - 1);
+    return min((octave - PROF_SUB_BITS + 1) * PROF_SUB_BUCKETS + sub,
+               PROF_BUCKETS - 1);
+}
+
+// The smallest time that is beyond a bucket.
+static uint64_t _bucket_limit(int bucket)
+{
+    if (bucket < PROF_SUB_BUCKETS)
+        return bucket + 1;
+
+    const int octave = bucket / PROF_SUB_BUCKETS + PROF_SUB_BITS - 1;
+    const int sub = bucket % PROF_SUB_BUCKETS;
+    return uint64_t(PROF_SUB_BUCKETS + sub + 1) << (octave - PROF_SUB_BITS);
+}
+
+void prof_record(prof_phase phase, chrono::steady_clock::duration elapsed)
+{
+    ASSERT_RANGE(phase, 0, NUM_PROF_PHASES);
+    const uint64_t ns = max<int64_t>(0,
+        chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+
+    prof_histogram &hist = histograms[phase];
+    ++hist.count;
+    hist.total_ns += ns;
+    hist.max_ns = max(hist.max_ns, ns);
+    ++hist.buckets[_bucket(ns)];
+}
+
+void prof_reset()
+{
+    memset(histograms, 0, sizeof(histograms));
+}
+
+/**
+ * Estimate a percentile of a phase's samples, as the upper end of the bucket
+ * that it falls in.
+ *
+ * @param hist    The phase's histogram, which must have some samples.
+ * @param percent Which percentile, from 1 to 100.
+ * @return the estimate in nanoseconds.
+ */
+static uint64_t _percentile(const prof_histogram &hist, int percent)
+{
+    const uint64_t rank = max<uint64_t>(1, (hist.count * percent + 99) / 100);
+    uint64_t seen = 0;
+    for (int b = 0; b < PROF_BUCKETS; b++)
+    {
+        seen += hist.buckets[b];
+        if (seen >= rank)
+            return min(_bucket_limit(b) - 1, hist.max_ns);
+    }
+    return hist.max_ns;
+}
+
+/**
+ * Summarise the samples of every phase so far, one line per phase after a
+ * header. Times other than the total are in microseconds.
+ */
+vector<string> prof_report()
+{
+    vector<string> lines;
+    lines.push_back(make_stringf("%-16s %9s %10s %9s %9s %9s %9s",
+                                 "Phase", "Samples", "Total ms", "Mean us",
+                                 "p50 us", "p99 us", "Max us"));
+    for (int i = 0; i < NUM_PROF_PHASES; i++)
+    {
+        const prof_histogram &hist = histograms[i];
+        if (!hist.count)
+        {
+            lines.push_back(make_stringf("%-16s %9d", phase_names[i], 0));
+            continue;
+        }
+        lines.push_back(make_stringf(
+            "%-16s %9" PRIu64 " %10.1f %9.1f %9.1f %9.1f %9.1f",
+            phase_names[i], hist.count, hist.total_ns / 1e6,
+            hist.total_ns / 1e3 / hist.count, _percentile(hist, 50) / 1e3,
+            _percentile(hist, 99) / 1e3, hist.max_ns / 1e3));
+    }
+    return lines;
+}
+
+/**
+ * Write the report to turn-profile-<name>.txt in the morgue directory, if
+ * anything was recorded. Called at exit.
+ */
+void prof_dump()
+{
+    bool any = false;
+    for (const prof_histogram &hist : histograms)
+        any = any || hist.count;
+    if (!any)
+        return;
+
+    const string file_name = morgue_directory() + "turn-profile-"
+                             + strip_filename_unsafe_chars(you.your_name)
+                             + ".txt";
+    FILE *f = fopen_replace(file_name.c_str());
+    if (!f)
+        return;
+    for (const string &line : prof_report())
+        fprintf(f, "%s\n", line.c_str());
+    fclose(f);
+}
+
+#ifdef WIZARD
+void debug_turn_profile()
+{
+    for (const string &line : prof_report())
+        mprf("%s", line.c_str());
+
+    const char *prompt = prof_enabled
+        ? "Stop profiling turns?"
+        : "Start profiling turns? This clears the samples so far.";
+    if (!yesno(prompt, true, 'n'))
+    {
+        canned_msg(MSG_OK);
+        return;
+    }
+
+    prof_enabled = !prof_enabled;
+    if (prof_enabled)
+        prof_reset();
+    mprf("Turn profiling is %s.", prof_enabled ? "on" : "off");
+}
+#endif
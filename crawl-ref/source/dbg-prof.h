@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Timers for the phases of a game turn.
+**/
+
+#pragma once
+
+#include <chrono>
+
+enum prof_phase
+{
+    PROF_WORLD_REACTS,
+    PROF_MONSTERS,
+    PROF_MONSTER_MOVE,
+    PROF_CLOUDS,
+    PROF_NOISES,
+    PROF_LOS,
+    PROF_VIEWWINDOW,
+    PROF_UPDATE_LEVEL,
+    PROF_SEND_MAP,
+    NUM_PROF_PHASES
+};
+
+// Whether prof_timers record anything; set from the turn_profile option.
+extern bool prof_enabled;
+
+void prof_record(prof_phase phase, chrono::steady_clock::duration elapsed);
+void prof_reset();
+vector<string> prof_report();
+void prof_dump();
+#ifdef WIZARD
+void debug_turn_profile();
+#endif
+
+/**
+ * Times the scope it lives in as one sample of a phase. When profiling is off
+ * this costs a single flag test.
+ *
+ * Phases nest: a monster's move is also part of handle_monsters(), which is
+ * part of world_reacts(), and each is timed in full.
+ */
+class prof_timer
+{
+public:
+    explicit prof_timer(prof_phase p) : phase(p), running(prof_enabled)
+    {
+        if (running)
+            start = chrono::steady_clock::now();
+    }
+
+    ~prof_timer()
+    {
+        if (running)
+            prof_record(phase, chrono::steady_clock::now() - start);
+    }
+
+private:
+    prof_phase phase;
+    bool running;
+    chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,266 @@
+/**
+ * @file
+ * @brief Recording and replaying keystrokes, for performance testing.
+ *
+ * -record-keys logs every key read from the terminal, one command (and the
+ * keys answering its prompts) per line. -replay-keys feeds such a log back
+ * in place of the terminal; given the same rc file, which must fix the
+ * game_seed and the character, the game plays out the same way. When the
+ * log runs out, the wall time of each command, and in builds with
+ * DEBUG_ALLOC_TAGS the heap allocations, are written to replay-<log name>.tsv
+ * and the game exits.
+**/
+
+#include "AppHdr.h"
+
+#include "dbg-replay.h"
+
+#include <chrono>
+#include <cinttypes>
+
+#include "dbg-alloc.h"
+#include "end.h"
+#include "files.h"
+#include "initfile.h"
+#include "macro.h"
+#include "state.h"
+#include "stringutil.h"
+#include "syscalls.h"
+#include "unicode.h"
+#include "version.h"
+
+typedef chrono::steady_clock replay_clock;
+
+static bool key_replay_inited = false;
+
+static FILE *record_file = nullptr;
+static string record_line;
+
+static bool replaying = false;
+static deque<int> replay_queue;
+static size_t replay_key_count = 0;
+static replay_clock::time_point replay_start;
+
+// The command being timed, and the wall times of those finished so far.
+static command_type timed_cmd = CMD_NO_CMD;
+static replay_clock::time_point timed_cmd_start;
+static map<string, vector<double>> cmd_times_ms;
+
+// Keys are written as themselves if they are printable ASCII, and otherwise
+// as \{keycode}, the same escape that macro files use. '#' is escaped too so
+// that no line of keys looks like a comment.
+static string _encode_key(int key)
+{
+    if (key == '\\')
+        return "\\\\";
+    if (key <= ' ' || key > '~' || key == '#')
+        return make_stringf("\\{%d}", key);
+    return string(1, static_cast<char>(key));
+}
+
+static bool _decode_keys(const string &line, deque<int> &keys)
+{
+    for (string::size_type i = 0; i < line.size(); ++i)
+    {
+        if (line[i] != '\\')
+        {
+            keys.push_back(static_cast<unsigned char>(line[i]));
+            continue;
+        }
+
+        if (i + 1 < line.size() && line[i + 1] == '\\')
+        {
+            keys.push_back('\\');
+            ++i;
+            continue;
+        }
+
+        const string::size_type close = line.find('}', i);
+        if (i + 1 >= line.size() || line[i + 1] != '{' || close == string::npos)
+            return false;
+
+        keys.push_back(atoi(line.substr(i + 2, close - i - 2).c_str()));
+        i = close;
+    }
+    return true;
+}
+
+static void _load_key_log(const string &filename)
+{
+    UTF8FileLineInput log(filename.c_str());
+    if (log.error())
+        end(1, true, "Can't read key log '%s'", filename.c_str());
+
+    for (int line_num = 1; !log.eof(); ++line_num)
+    {
+        string line = log.get_line();
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (!_decode_keys(line, replay_queue))
+        {
+            end(1, false, "%s:%d: bad key escape in '%s'", filename.c_str(),
+                line_num, line.c_str());
+        }
+    }
+
+    replay_key_count = replay_queue.size();
+    replaying = true;
+    alloc_counting = true;
+    replay_start = replay_clock::now();
+}
+
+static void _init_key_replay()
+{
+    if (key_replay_inited)
+        return;
+    key_replay_inited = true;
+
+    if (!SysEnv.record_keys.empty())
+    {
+        record_file = fopen_u(SysEnv.record_keys.c_str(), "w");
+        if (!record_file)
+        {
+            end(1, true, "Can't write key log '%s'",
+                SysEnv.record_keys.c_str());
+        }
+        fprintf(record_file, "# Keys recorded by %s %s.\n", CRAWL,
+                Version::Long);
+        fprintf(record_file, "# Replay with -replay-keys and the same rc.\n");
+    }
+
+    if (!SysEnv.replay_keys.empty())
+        _load_key_log(SysEnv.replay_keys);
+}
+
+static void _flush_record_line()
+{
+    if (record_line.empty())
+        return;
+
+    fprintf(record_file, "%s\n", record_line.c_str());
+    // Keep the log intact if the game then crashes: that's when it's wanted.
+    fflush(record_file);
+    record_line.clear();
+}
+
+static void _finish_timed_cmd(replay_clock::time_point now)
+{
+    if (timed_cmd != CMD_NO_CMD)
+    {
+        const chrono::duration<double, milli> elapsed = now - timed_cmd_start;
+        cmd_times_ms[command_to_name(timed_cmd)].push_back(elapsed.count());
+    }
+    timed_cmd = CMD_NO_CMD;
+}
+
+// The value below which percent% of the sorted times fall.
+static double _percentile(const vector<double> &sorted, int percent)
+{
+    const size_t rank = max<size_t>(1, (sorted.size() * percent + 99) / 100);
+    return sorted[rank - 1];
+}
+
+static void _write_cmd_times(FILE *f, const string &name,
+                             vector<double> &times)
+{
+    sort(times.begin(), times.end());
+    double total = 0;
+    for (double t : times)
+        total += t;
+    fprintf(f, "%s\t%u\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\t%.3f\n", name.c_str(),
+            (unsigned int) times.size(), total, total / times.size(),
+            _percentile(times, 50), _percentile(times, 90),
+            _percentile(times, 99), times.back());
+}
+
+NORETURN static void _finish_replay()
+{
+    const replay_clock::time_point now = replay_clock::now();
+    _finish_timed_cmd(now);
+    alloc_counting = false;
+    const chrono::duration<double, milli> wall = now - replay_start;
+
+    string name = get_base_filename(SysEnv.replay_keys);
+    if (ends_with(name, ".keys"))
+        name.erase(name.size() - strlen(".keys"));
+    const string report = "replay-" + name + ".tsv";
+    FILE *f = fopen_replace(report.c_str());
+    if (!f)
+        end(1, true, "Can't write replay report '%s'", report.c_str());
+
+    fprintf(f, "# %s %s replaying %s\n", CRAWL, Version::Long,
+            SysEnv.replay_keys.c_str());
+    fprintf(f, "keys\t%u\n", (unsigned int) replay_key_count);
+    fprintf(f, "wall_ms\t%.3f\n", wall.count());
+#ifdef DEBUG_ALLOC_TAGS
+    const alloc_totals allocs = alloc_counted();
+    fprintf(f, "allocations\t%" PRIu64 "\n", allocs.count);
+    fprintf(f, "allocated_bytes\t%" PRIu64 "\n", allocs.bytes);
+#endif
+    fprintf(f, "\ncommand\tcount\ttotal_ms\tmean_ms\tp50_ms\tp90_ms"
+               "\tp99_ms\tmax_ms\n");
+
+    vector<double> all;
+    for (auto &entry : cmd_times_ms)
+    {
+        _write_cmd_times(f, entry.first, entry.second);
+        all.insert(all.end(), entry.second.begin(), entry.second.end());
+    }
+    if (!all.empty())
+        _write_cmd_times(f, "all", all);
+    fclose(f);
+
+    end(0);
+}
+
+bool key_replay_active()
+{
+    _init_key_replay();
+    return replaying;
+}
+
+/**
+ * The next key of the log being replayed. If there are none left, this writes
+ * the report and exits.
+ */
+int key_replay_next()
+{
+    ASSERT(replaying);
+    if (replay_queue.empty())
+        _finish_replay();
+
+    const int key = replay_queue.front();
+    replay_queue.pop_front();
+    return key;
+}
+
+/// Log a key read from the terminal, if recording.
+void key_record(int key)
+{
+    _init_key_replay();
+    if (!record_file)
+        return;
+
+    // Each command starts a new line, followed by any keys its prompts read.
+    if (crawl_state.waiting_for_command)
+        _flush_record_line();
+    record_line += _encode_key(key);
+}
+
+/**
+ * Note that the main loop has read a command. When replaying, this ends the
+ * timing of the previous command: everything from reading one command to
+ * reading the next, including prompts and redraws, counts towards the first.
+ */
+void key_replay_command(command_type cmd)
+{
+    if (!replaying || cmd == CMD_NO_CMD || cmd == CMD_NEXT_CMD)
+        return;
+
+    const replay_clock::time_point now = replay_clock::now();
+    _finish_timed_cmd(now);
+    timed_cmd = cmd;
+    timed_cmd_start = now;
+}
@@ -0,0 +1,13 @@
+/**
+ * @file
+ * @brief Recording and replaying keystrokes, for performance testing.
+**/
+
+#pragma once
+
+#include "command-type.h"
+
+bool key_replay_active();
+int key_replay_next();
+void key_record(int key);
+void key_replay_command(command_type cmd);
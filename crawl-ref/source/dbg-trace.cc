@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Tracing of spans of work, in Chrome's trace event format.
+ *
+ * -trace <file> writes a JSON array of trace events, which chrome://tracing
+ * and Perfetto can both open. Events are buffered and written out whenever
+ * the buffer fills, so memory use stays bounded however long the game runs.
+ * The array is closed on exit; the viewers accept one left open by a crash.
+**/
+
+#include "AppHdr.h"
+
+#include "dbg-trace.h"
+
+#ifdef UNIX
+# include <unistd.h>
+#endif
+
+#include "end.h"
+#include "stringutil.h"
+#include "syscalls.h"
+#include "version.h"
+
+// How much of the trace to hold before writing it out.
+#define TRACE_BUFFER_BYTES (256 * 1024)
+
+bool trace_enabled = false;
+
+static FILE *trace_file = nullptr;
+static string trace_buffer;
+static chrono::steady_clock::time_point trace_epoch;
+#ifdef UNIX
+// Workers forked for -mapstat and -arena-jobs inherit the buffer, and must
+// not write it out a second time.
+static pid_t trace_pid;
+#endif
+
+static void _flush_trace()
+{
+#ifdef UNIX
+    if (getpid() != trace_pid)
+    {
+        trace_enabled = false;
+        trace_buffer.clear();
+        return;
+    }
+#endif
+    fwrite(trace_buffer.data(), 1, trace_buffer.size(), trace_file);
+    fflush(trace_file);
+    trace_buffer.clear();
+}
+
+static void _append_json_string(string &out, const string &s)
+{
+    out += '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += c;
+        }
+        else if (static_cast<unsigned char>(c) < ' ')
+            out += make_stringf("\\u%04x", c);
+        else
+            out += c;
+    }
+    out += '"';
+}
+
+// Microseconds since the trace started, as the viewers expect.
+static double _trace_us(chrono::steady_clock::time_point t)
+{
+    return chrono::duration<double, micro>(t - trace_epoch).count();
+}
+
+static void _append_event(const char *category, const string &name,
+                          const string &detail, const char *fields)
+{
+    if (!trace_file)
+        return;
+
+    trace_buffer += "{\"name\":";
+    _append_json_string(trace_buffer, name);
+    trace_buffer += ",\"cat\":\"";
+    trace_buffer += category;
+    trace_buffer += "\",";
+    trace_buffer += fields;
+    trace_buffer += ",\"pid\":1,\"tid\":1";
+    if (!detail.empty())
+    {
+        trace_buffer += ",\"args\":{\"detail\":";
+        _append_json_string(trace_buffer, detail);
+        trace_buffer += '}';
+    }
+    trace_buffer += "},\n";
+
+    if (trace_buffer.size() >= TRACE_BUFFER_BYTES)
+        _flush_trace();
+}
+
+/// Start writing a trace to filename, replacing anything already there.
+void trace_start(const string &filename)
+{
+    trace_file = fopen_u(filename.c_str(), "w");
+    if (!trace_file)
+        end(1, true, "Can't write trace '%s'", filename.c_str());
+
+    trace_buffer.reserve(TRACE_BUFFER_BYTES + 1024);
+    trace_epoch = chrono::steady_clock::now();
+#ifdef UNIX
+    trace_pid = getpid();
+#endif
+    trace_enabled = true;
+
+    trace_buffer += "[\n";
+    string process = make_stringf("%s %s", CRAWL, Version::Long);
+    trace_buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+                    "\"args\":{\"name\":";
+    _append_json_string(trace_buffer, process);
+    trace_buffer += "}},\n";
+}
+
+/// Record a span of work from start to finish; see trace_span.
+void trace_record(const char *category, const char *name, const string &label,
+                  const string &detail, chrono::steady_clock::time_point start,
+                  chrono::steady_clock::time_point finish)
+{
+    const string fields = make_stringf("\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                                       _trace_us(start),
+                                       _trace_us(finish) - _trace_us(start));
+    _append_event(category, label.empty() ? string(name) : label, detail,
+                  fields.c_str());
+}
+
+/// Record something that happened at one moment, such as a level veto.
+void trace_instant(const char *category, const char *name,
+                   const string &detail)
+{
+    if (!trace_enabled)
+        return;
+
+    const string fields = make_stringf("\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f",
+                             _trace_us(chrono::steady_clock::now()));
+    _append_event(category, name, detail, fields.c_str());
+}
+
+/// Write out the rest of the trace and close it. Called at exit.
+void trace_finish()
+{
+    if (!trace_file)
+        return;
+
+    // Every event ends with a comma, so the last one is written here.
+    trace_buffer += make_stringf("{\"name\":\"exit\",\"cat\":\"game\","
+                                 "\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,"
+                                 "\"pid\":1,\"tid\":1}\n]\n",
+                                 _trace_us(chrono::steady_clock::now()));
+    _flush_trace();
+    fclose(trace_file);
+    trace_file = nullptr;
+    trace_enabled = false;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Tracing of spans of work, in Chrome's trace event format.
+**/
+
+#pragma once
+
+#include <chrono>
+
+// Whether trace_spans record anything; set by -trace.
+extern bool trace_enabled;
+
+void trace_start(const string &filename);
+void trace_record(const char *category, const char *name, const string &label,
+                  const string &detail, chrono::steady_clock::time_point start,
+                  chrono::steady_clock::time_point finish);
+void trace_instant(const char *category, const char *name,
+                   const string &detail = "");
+void trace_finish();
+
+/**
+ * Records the scope it lives in as one span of the trace. When tracing is off
+ * this costs a single flag test.
+ *
+ * A span is shown under its name, or its label if it has been given one.
+ * Labels and details are only wanted when tracing, so build them inside
+ * "if (span.active())", to keep the cost off untraced games.
+ */
+class trace_span
+{
+public:
+    trace_span(const char *cat, const char *n)
+        : category(cat), name(n), running(trace_enabled)
+    {
+        if (running)
+            start = chrono::steady_clock::now();
+    }
+
+    ~trace_span()
+    {
+        if (running)
+        {
+            trace_record(category, name, label, detail, start,
+                         chrono::steady_clock::now());
+        }
+    }
+
+    bool active() const { return running; }
+    void set_label(const string &l) { label = l; }
+    void set_detail(const string &d) { detail = d; }
+
+private:
+    const char *category;
+    const char *name;
+    string label;
+    string detail;
+    bool running;
+    chrono::steady_clock::time_point start;
+};
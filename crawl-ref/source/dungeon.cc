@@ -29,6 +29,7 @@
 #include "directn.h"
 #include "dbg-maps.h"
 #include "dbg-scan.h"
+#include "dbg-trace.h"
 #include "dgn-delve.h"
 #include "dgn-height.h"
 #include "dgn-overview.h"
@@ -262,6 +263,10 @@ bool builder(bool enable_random_maps)
     ASSERT_RANGE(you.where_are_you, 0, NUM_BRANCHES);
     ASSERT_RANGE(you.depth, 0 + 1, brdepth[you.where_are_you] + 1);
 
+    trace_span span("builder", "builder");
+    if (span.active())
+        span.set_detail(level_id::current().describe());
+
     const set<string> uniq_tags = get_uniq_map_tags();
     const set<string> uniq_names = get_uniq_map_names();
 
@@ -282,6 +287,9 @@ bool builder(bool enable_random_maps)
 
     unwind_bool levelgen(crawl_state.generating_level, true);
     rng::generator levelgen_rng(you.where_are_you);
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_BUILDER);
+#endif
 
 #ifdef DEBUG_DIAGNOSTICS // no point in enabling unless dprf works
     CrawlHashTable &debug_logs = you.props["debug_builder_logs"].get_table();
@@ -401,6 +409,7 @@ void dgn_record_veto(const dgn_veto_exception &e)
     crawl_state.last_builder_error = error;
 
     dprf(DIAG_DNGN, "<white>VETO</white>: %s", error.c_str());
+    trace_instant("builder", "veto", error);
 
 #ifdef DEBUG_STATISTICS
     mapstat_report_map_veto(e.what());
@@ -410,7 +419,12 @@ void dgn_record_veto(const dgn_veto_exception &e)
 
 static bool _build_level_vetoable(bool enable_random_maps)
 {
+    trace_span span("builder", "build attempt");
+    if (span.active())
+        span.set_detail(level_id::current().describe());
+
 #ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_ATTEMPT);
     mapstat_report_map_build_start();
 #endif
 
@@ -439,6 +453,7 @@ static bool _build_level_vetoable(bool enable_random_maps)
     if (crawl_state.game_standard_levelgen()
         && !_valid_dungeon_level())
     {
+        trace_instant("builder", "veto", "D:1 exit stairs not connected.");
         return false;
     }
 
@@ -1134,6 +1149,9 @@ static int _process_disconnected_zones(int x1, int y1, int x2, int y2,
 int dgn_count_disconnected_zones(bool choose_stairless,
                                  dungeon_feature_type fill)
 {
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_CONNECTIVITY);
+#endif
     return _process_disconnected_zones(0, 0, GXM-1, GYM-1, choose_stairless,
                                        fill);
 }
@@ -2135,6 +2153,10 @@ static bool _branch_needs_stairs()
 
 static void _dgn_verify_connectivity(unsigned nvaults)
 {
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_CONNECTIVITY);
+#endif
+
     // After placing vaults, make sure parts of the level have not been
     // disconnected.
     if (dgn_zones && nvaults != env.level_vaults.size())
@@ -14,6 +14,10 @@
 #include "colour.h"
 #include "crash.h"
 #include "database.h"
+#include "dbg-alloc.h"
+#include "dbg-luaprof.h"
+#include "dbg-prof.h"
+#include "dbg-trace.h"
 #include "describe.h"
 #include "dungeon.h"
 #include "files.h"
@@ -196,6 +200,10 @@ NORETURN void end(int exit_code, bool print_error, const char *format, ...)
         tiles.shutdown();
 #endif
 
+        prof_dump();
+        alloc_dump();
+        lua_prof_dump();
+        trace_finish();
         cio_cleanup();
         msg::deinitialise_mpr_streams();
         _clear_globals_on_exit();
@@ -43,6 +43,7 @@
 #include "cloud.h"
 #include "coordit.h"
 #include "dactions.h"
+#include "dbg-trace.h"
 #include "dbg-util.h"
 #include "dgn-overview.h"
 #include "directn.h"
@@ -1915,6 +1916,10 @@ bool load_level(dungeon_feature_type stair_taken, load_mode_type load_mode,
     if (!you.save->has_chunk(level_name) && load_mode == LOAD_VISITOR)
         return false;
 
+    trace_span span("level", "load level");
+    if (span.active())
+        span.set_detail(level_name);
+
     const bool make_changes =
         (load_mode == LOAD_START_GAME || load_mode == LOAD_ENTER_LEVEL);
 
@@ -2291,6 +2296,10 @@ bool load_level(dungeon_feature_type stair_taken, load_mode_type load_mode,
 
 static void _save_level(const level_id& lid)
 {
+    trace_span span("level", "save level");
+    if (span.active())
+        span.set_detail(lid.describe());
+
     if (you.level_visited(lid))
         travel_cache.get_level_info(lid).update();
 
@@ -3110,6 +3119,21 @@ bool is_existing_level(const level_id &level)
     return you.save && you.save->has_chunk(level.describe());
 }
 
+/**
+ * Start reading a saved level in the background, so that going there only
+ * has to unmarshall it. Called when the player is on or heading for stairs.
+ *
+ * @param level The level the stairs lead to; ignored unless it is saved.
+ */
+void prefetch_level(const level_id &level)
+{
+    if (level.is_valid() && level != level_id::current()
+        && is_existing_level(level))
+    {
+        you.save->prefetch(level.describe());
+    }
+}
+
 void delete_level(const level_id &level)
 {
     travel_cache.erase_level_info(level);
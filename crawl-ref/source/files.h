@@ -103,6 +103,7 @@ bool save_exists(const string& filename);
 bool restore_game(const string& filename);
 
 bool is_existing_level(const level_id &level);
+void prefetch_level(const level_id &level);
 
 class level_excursion
 {
@@ -30,6 +30,9 @@
 #include "clua.h"
 #include "colour.h"
 #include "confirm-butcher-type.h"
+#include "dbg-luaprof.h"
+#include "dbg-prof.h"
+#include "dbg-trace.h"
 #include "defines.h"
 #include "delay.h"
 #include "describe.h"
@@ -150,6 +153,8 @@ const vector<GameOption*> game_options::build_options_list()
         new BoolGameOption(SIMPLE_NAME(easy_door), true),
         new BoolGameOption(SIMPLE_NAME(default_show_all_skills), false),
         new BoolGameOption(SIMPLE_NAME(read_persist_options), false),
+        new BoolGameOption(SIMPLE_NAME(turn_profile), false),
+        new IntGameOption(SIMPLE_NAME(mem_sample_turns), 0, 0, INT_MAX),
         new BoolGameOption(SIMPLE_NAME(auto_switch), false),
         new BoolGameOption(SIMPLE_NAME(suppress_startup_errors), false),
         new BoolGameOption(SIMPLE_NAME(simple_targeting), false),
@@ -209,6 +214,9 @@ const vector<GameOption*> game_options::build_options_list()
         new BoolGameOption(SIMPLE_NAME(show_travel_trail), USING_DGL),
         new BoolGameOption(SIMPLE_NAME(use_fake_cursor), USING_UNIX ),
         new BoolGameOption(SIMPLE_NAME(use_fake_player_cursor), true),
+        new BoolGameOption(SIMPLE_NAME(synchronized_output), false),
+        new BoolGameOption(SIMPLE_NAME(terminal_output_stats), false),
+        new BoolGameOption(SIMPLE_NAME(batch_screen_updates), false),
         new BoolGameOption(SIMPLE_NAME(show_player_species), false),
         new BoolGameOption(SIMPLE_NAME(use_modifier_prefix_keys), true),
         new BoolGameOption(SIMPLE_NAME(ability_menu), true),
@@ -260,6 +268,8 @@ const vector<GameOption*> game_options::build_options_list()
         new IntGameOption(SIMPLE_NAME(hp_warning), 30, 0, 100),
         new IntGameOption(magic_point_warning, {"mp_warning"}, 0, 0, 100),
         new IntGameOption(SIMPLE_NAME(autofight_warning), 0, 0, 1000),
+        new IntGameOption(SIMPLE_NAME(screen_keyframe_interval), 0, 0,
+                          INT_MAX),
         // These need to be odd, hence allow +1.
         new IntGameOption(SIMPLE_NAME(view_max_width),
                       max(VIEW_BASE_WIDTH, VIEW_MIN_WIDTH),
@@ -418,6 +428,8 @@ const vector<GameOption*> game_options::build_options_list()
         new StringGameOption(SIMPLE_NAME(fsim_mode), ""),
         new StringGameOption(SIMPLE_NAME(fsim_mons), ""),
         new IntGameOption(SIMPLE_NAME(fsim_rounds), 4000, 1000, 500000),
+        new IntGameOption(SIMPLE_NAME(fsim_precision), 0, 0, 100),
+        new IntGameOption(SIMPLE_NAME(fsim_jobs), 1, 1, 256),
 #endif
 #if !defined(DGAMELAUNCH) || defined(DGL_REMEMBER_NAME)
         new BoolGameOption(SIMPLE_NAME(remember_name), true),
@@ -1215,6 +1227,7 @@ void game_options::reset_options()
     enemy_hp_colour.push_back(RED);
 
     force_autopickup.clear();
+    autopickup_options_changed();
     autoinscriptions.clear();
     note_skill_levels.reset();
     note_skill_levels.set(1);
@@ -1230,6 +1243,7 @@ void game_options::reset_options()
     sound_mappings.clear();
     menu_colour_mappings.clear();
     message_colour_mappings.clear();
+    message_filters_changed();
     named_options.clear();
 
     clear_cset_overrides();
@@ -2065,6 +2079,9 @@ void game_options::read_options(LineInput &il, bool runscript,
 #endif
     }
 
+    // Any Lua run above may have changed the autopickup functions.
+    if (runscript)
+        autopickup_options_changed();
 }
 
 void game_options::fixup_options()
@@ -2078,6 +2095,8 @@ void game_options::fixup_options()
 
     if (!check_mkdir("Morgue directory", &morgue_dir))
         end(1, false, "Cannot create morgue directory '%s'", morgue_dir.c_str());
+
+    prof_enabled = turn_profile;
 }
 
 static int _str_to_killcategory(const string &s)
@@ -2369,6 +2388,20 @@ void game_options::add_message_colour_mappings(const string &field,
         add_message_colour_mapping(fragment, prepend, subtract);
 }
 
+// Every change gets a number never used before, even by another copy of
+// the options.
+void game_options::message_filters_changed()
+{
+    static unsigned next_generation = 0;
+    message_filter_generation = ++next_generation;
+}
+
+void game_options::autopickup_options_changed()
+{
+    static unsigned next_generation = 0;
+    autopickup_generation = ++next_generation;
+}
+
 message_filter game_options::parse_message_filter(const string &filter)
 {
     string::size_type pos = filter.find(":");
@@ -2722,6 +2755,7 @@ void game_options::read_option_line(const string &str, bool runscript)
             else
                 report_error("Bad object type '%*s' for autopickup.\n", s, tp);
         }
+        autopickup_options_changed();
     }
 #if !defined(DGAMELAUNCH) || defined(DGL_REMEMBER_NAME)
     else if (key == "name")
@@ -3076,6 +3110,7 @@ void game_options::read_option_line(const string &str, bool runscript)
                 new_entries.push_back(f_a);
         }
         merge_lists(force_autopickup, new_entries, caret_equal);
+        autopickup_options_changed();
     }
     else if (key == "autopickup_exceptions")
     {
@@ -3103,6 +3138,7 @@ void game_options::read_option_line(const string &str, bool runscript)
                 new_entries.push_back(f_a);
         }
         merge_lists(force_autopickup, new_entries, caret_equal);
+        autopickup_options_changed();
     }
 #ifndef _MSC_VER
     // break if-else chain on broken Microsoft compilers with stupid nesting limits
@@ -3295,6 +3331,7 @@ void game_options::read_option_line(const string &str, bool runscript)
                 new_entries.push_back(mf);
         }
         merge_lists(filters, new_entries, caret_equal);
+        message_filters_changed();
     }
     else if (key == "travel_avoid_terrain")
     {
@@ -3392,6 +3429,7 @@ void game_options::read_option_line(const string &str, bool runscript)
             message_colour_mappings.clear();
 
         add_message_colour_mappings(field, caret_equal, minus_equal);
+        message_filters_changed();
     }
     else if (key == "dump_order")
     {
@@ -3982,8 +4020,10 @@ enum commandline_option_type
     CLO_MAPSTAT_DUMP_DISCONNECT,
     CLO_OBJSTAT,
     CLO_ITERATIONS,
+    CLO_STAT_JOBS,
     CLO_FORCE_MAP,
     CLO_ARENA,
+    CLO_ARENA_JOBS,
     CLO_DUMP_MAPS,
     CLO_TEST,
     CLO_SCRIPT,
@@ -4012,6 +4052,11 @@ enum commandline_option_type
     CLO_SAVE_JSON,
     CLO_GAMETYPES_JSON,
     CLO_EDIT_BONES,
+    CLO_RECORD_KEYS,
+    CLO_REPLAY_KEYS,
+    CLO_MEM_REPORT,
+    CLO_TRACE,
+    CLO_LUA_PROFILE,
 #ifdef USE_TILE_WEB
     CLO_WEBTILES_SOCKET,
     CLO_AWAIT_CONNECTION,
@@ -4025,12 +4070,14 @@ static const char *cmd_ops[] =
 {
     "scores", "name", "species", "background", "dir", "rc", "rcdir", "tscores",
     "vscores", "scorefile", "morgue", "macro", "mapstat", "dump-disconnect",
-    "objstat", "iters", "force-map", "arena", "dump-maps", "test", "script",
+    "objstat", "iters", "stat-jobs", "force-map", "arena", "arena-jobs", "dump-maps", "test", "script",
     "builddb", "help", "version", "seed", "pregen", "save-version", "sprint",
     "extra-opt-first", "extra-opt-last", "sprint-map", "edit-save",
     "print-charset", "tutorial", "wizard", "explore", "no-save", "gdb",
     "no-gdb", "nogdb", "throttle", "no-throttle", "playable-json",
     "branches-json", "save-json", "gametypes-json", "bones",
+    "record-keys", "replay-keys", "mem-report", "trace",
+    "lua-profile",
 #ifdef USE_TILE_WEB
     "webtiles-socket", "await-connection", "print-webtiles-options",
 #endif
@@ -4784,6 +4831,8 @@ bool parse_args(int argc, char **argv, bool rc_only)
 
     SysEnv.rcdirs.clear();
     SysEnv.map_gen_iters = 0;
+    SysEnv.map_gen_jobs = 1;
+    SysEnv.arena_jobs = 0;
 
     if (argc < 2)           // no args!
         return true;
@@ -4961,6 +5010,24 @@ bool parse_args(int argc, char **argv, bool rc_only)
 #endif
             break;
 
+        case CLO_STAT_JOBS:
+#ifdef DEBUG_STATISTICS
+            if (!next_is_param || !isadigit(*next_arg))
+                end(1, false, "Integer argument required for -%s\n", arg);
+            else
+            {
+                SysEnv.map_gen_jobs = atoi(next_arg);
+                if (SysEnv.map_gen_jobs < 1)
+                    SysEnv.map_gen_jobs = 1;
+                else if (SysEnv.map_gen_jobs > 256)
+                    SysEnv.map_gen_jobs = 256;
+                nextUsed = true;
+            }
+#else
+            end(1, false, "%s", dbg_stat_err);
+#endif
+            break;
+
         case CLO_FORCE_MAP:
 #ifdef DEBUG_STATISTICS
             if (!next_is_param)
@@ -4989,6 +5056,20 @@ bool parse_args(int argc, char **argv, bool rc_only)
             }
             break;
 
+        case CLO_ARENA_JOBS:
+            if (!next_is_param || !isadigit(*next_arg))
+                end(1, false, "Integer argument required for -%s\n", arg);
+            else
+            {
+                SysEnv.arena_jobs = atoi(next_arg);
+                if (SysEnv.arena_jobs < 1)
+                    SysEnv.arena_jobs = 1;
+                else if (SysEnv.arena_jobs > 256)
+                    SysEnv.arena_jobs = 256;
+                nextUsed = true;
+            }
+            break;
+
         case CLO_DUMP_MAPS:
             crawl_state.dump_maps = true;
             break;
@@ -5258,6 +5339,38 @@ bool parse_args(int argc, char **argv, bool rc_only)
             crawl_state.throttle = false;
             break;
 
+        case CLO_RECORD_KEYS:
+            if (!next_is_param)
+                return false;
+            SysEnv.record_keys = next_arg;
+            nextUsed = true;
+            break;
+
+        case CLO_REPLAY_KEYS:
+            if (!next_is_param)
+                return false;
+            SysEnv.replay_keys = next_arg;
+            nextUsed = true;
+            break;
+
+        case CLO_MEM_REPORT:
+            SysEnv.mem_report = true;
+            break;
+
+        case CLO_LUA_PROFILE:
+            SysEnv.lua_profile = true;
+            lua_prof_enabled = true;
+            break;
+
+        case CLO_TRACE:
+            if (!next_is_param)
+                return false;
+            // Start on the first pass, to include loading the maps.
+            if (rc_only)
+                trace_start(next_arg);
+            nextUsed = true;
+            break;
+
         case CLO_EXTRA_OPT_FIRST:
             if (!next_is_param)
                 return false;
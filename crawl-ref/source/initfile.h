@@ -61,6 +61,12 @@ public:
     vector<string> cmd_args;
 
     int map_gen_iters;
+    int map_gen_jobs;
+    int arena_jobs;
+    string record_keys;            // File to log keystrokes to.
+    string replay_keys;            // File of keystrokes to replay.
+    bool mem_report;               // Write a memory report on exit.
+    bool lua_profile;              // Write a Lua profile on exit.
     unique_ptr<depth_ranges> map_gen_range;
 
     vector<string> extra_opts_first;
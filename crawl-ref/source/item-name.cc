@@ -9,8 +9,11 @@
 
 #include <cctype>
 #include <cstring>
+#include <functional>
 #include <iomanip>
+#include <map>
 #include <sstream>
+#include <tuple>
 
 #include "areas.h"
 #include "artefact.h"
@@ -126,6 +129,100 @@ static string _item_inscription(const item_def &item)
                                              ", ").c_str());
 }
 
+/**
+ * Everything name_aux() looks at for the items _name_is_cacheable() allows,
+ * along with the arguments it was given.
+ */
+struct item_name_key
+{
+    object_class_type base_type;
+    uint8_t sub_type;
+    short plus;
+    short plus2;
+    int special;
+    uint8_t rnd;
+    short quantity;
+    iflags_t flags;
+    string inscription;
+    int equip_slot;
+    description_level_type desc;
+    bool terse;
+    bool ident;
+    bool with_inscription;
+    iflags_t ignore_flags;
+
+    item_name_key(const item_def &item, description_level_type _desc,
+                  bool _terse, bool _ident, bool _with_inscription,
+                  iflags_t _ignore_flags)
+        : base_type(item.base_type), sub_type(item.sub_type),
+          plus(item.plus), plus2(item.plus2), special(item.special),
+          rnd(item.rnd), quantity(item.quantity), flags(item.flags),
+          inscription(item.inscription),
+          // Only unworn jewellery says it is uncursed.
+          equip_slot(item.base_type == OBJ_JEWELLERY ? get_equip_slot(&item)
+                                                     : -1),
+          desc(_desc), terse(_terse), ident(_ident),
+          with_inscription(_with_inscription), ignore_flags(_ignore_flags)
+    {
+    }
+
+    bool operator<(const item_name_key &other) const
+    {
+        auto fields = [](const item_name_key &k)
+        {
+            return tie(k.base_type, k.sub_type, k.plus, k.plus2, k.special,
+                       k.rnd, k.quantity, k.flags, k.inscription,
+                       k.equip_slot, k.desc, k.terse, k.ident,
+                       k.with_inscription, k.ignore_flags);
+        };
+        return fields(*this) < fields(other);
+    }
+};
+
+// Names already built by name_aux(), for menus, stash searches and the like
+// that name the same few hundred items over and over.
+static map<item_name_key, string> _item_name_cache;
+static unsigned _item_name_cache_epoch = 0;
+static const size_t MAX_ITEM_NAME_CACHE = 4096;
+
+/**
+ * Can name_aux()'s result for this item be reused? Artefacts and anything
+ * else with props (named corpses, damnation bolts...) take their names from
+ * there, and miscellaneous items show the player's zig and evoker progress.
+ */
+static bool _name_is_cacheable(const item_def &item)
+{
+    return item.props.empty() && item.base_type != OBJ_MISCELLANY;
+}
+
+static string _cached_name_aux(const item_def &item,
+                               description_level_type desc, bool terse,
+                               bool ident, bool with_inscription,
+                               iflags_t ignore_flags,
+                               const function<string()> &make_name)
+{
+    if (!_name_is_cacheable(item))
+        return make_name();
+
+    // Unidentified items are named by type knowledge as well as by their
+    // own fields.
+    if (_item_name_cache_epoch != identification_epoch())
+    {
+        _item_name_cache.clear();
+        _item_name_cache_epoch = identification_epoch();
+    }
+
+    const item_name_key key(item, desc, terse, ident, with_inscription,
+                            ignore_flags);
+    auto cached = _item_name_cache.find(key);
+    if (cached != _item_name_cache.end())
+        return cached->second;
+
+    if (_item_name_cache.size() >= MAX_ITEM_NAME_CACHE)
+        _item_name_cache.clear();
+    return _item_name_cache[key] = make_name();
+}
+
 string item_def::name(description_level_type descrip, bool terse, bool ident,
                       bool with_inscription, bool quantity_in_words,
                       iflags_t ignore_flags) const
@@ -141,8 +238,13 @@ string item_def::name(description_level_type descrip, bool terse, bool ident,
 
     ostringstream buff;
 
-    const string auxname = name_aux(descrip, terse, ident, with_inscription,
-                                    ignore_flags);
+    const string auxname = _cached_name_aux(*this, descrip, terse, ident,
+                                            with_inscription, ignore_flags,
+        [&]
+        {
+            return name_aux(descrip, terse, ident, with_inscription,
+                            ignore_flags);
+        });
 
     const bool startvowel     = is_vowel(auxname[0]);
 
@@ -2064,6 +2166,7 @@ bool set_ident_type(object_class_type basetype, int subtype, bool identify)
         return false;
 
     you.type_ids[basetype][subtype] = identify;
+    item_type_knowledge_changed();
     request_autoinscribe();
 
     // Our item knowledge changed in a way that could possibly affect shop
@@ -2078,6 +2181,23 @@ bool set_ident_type(object_class_type basetype, int subtype, bool identify)
     return true;
 }
 
+static unsigned _identification_epoch = 0;
+
+/**
+ * A number that changes whenever you.type_ids might have, so that anything
+ * derived from item type knowledge can tell whether it is stale.
+ */
+unsigned identification_epoch()
+{
+    return _identification_epoch;
+}
+
+/// Call after changing you.type_ids other than through set_ident_type().
+void item_type_knowledge_changed()
+{
+    ++_identification_epoch;
+}
+
 void pack_item_identify_message(int base_type, int sub_type)
 {
     for (const auto &item : you.inv)
@@ -141,6 +141,8 @@ bool get_ident_type(const item_def &item);
 bool get_ident_type(object_class_type basetype, int subtype);
 bool set_ident_type(item_def &item, bool identify);
 bool set_ident_type(object_class_type basetype, int subtype, bool identify);
+unsigned identification_epoch();
+void item_type_knowledge_changed();
 void pack_item_identify_message(int base_type, int sub_type);
 
 string item_prefix(const item_def &item, bool temp = true);
@@ -14,6 +14,8 @@
 #include <cstring>
 #include <functional> // mem_fn
 #include <limits>
+#include <map>
+#include <tuple>
 
 #include "adjust.h"
 #include "areas.h"
@@ -2863,17 +2865,80 @@ static int _autopickup_subtype(const item_def &item)
     }
 }
 
-static bool _is_option_autopickup(const item_def &item, bool ignore_force)
+/**
+ * Everything about an item that goes into its name, and so into the string
+ * handed to ch_force_autopickup and matched against autopickup_exceptions.
+ */
+struct autopickup_key
 {
-    if (item.base_type < NUM_OBJECT_CLASSES)
+    object_class_type base_type;
+    uint8_t sub_type;
+    short plus;
+    short plus2;
+    int special;
+    uint8_t rnd;
+    short quantity;
+    iflags_t flags;
+    string inscription;
+
+    explicit autopickup_key(const item_def &item)
+        : base_type(item.base_type), sub_type(item.sub_type),
+          plus(item.plus), plus2(item.plus2), special(item.special),
+          rnd(item.rnd), quantity(item.quantity), flags(item.flags),
+          inscription(item.inscription)
     {
-        const int force = item_autopickup_level(item);
-        if (!ignore_force && force != AP_FORCE_NONE)
-            return force == AP_FORCE_ON;
     }
-    else
-        return false;
 
+    bool operator<(const autopickup_key &other) const
+    {
+        auto fields = [](const autopickup_key &k)
+        {
+            return tie(k.base_type, k.sub_type, k.plus, k.plus2, k.special,
+                       k.rnd, k.quantity, k.flags, k.inscription);
+        };
+        return fields(*this) < fields(other);
+    }
+};
+
+// Decisions made by the Lua hook and the autopickup options. Explore and
+// travel ask about every item in view many times a turn, and building the
+// name and matching it against every pattern dominates on item-rich levels.
+static map<autopickup_key, bool> _autopickup_cache;
+static const size_t MAX_AUTOPICKUP_CACHE = 1024;
+
+/**
+ * Throw the cached decisions away if anything they may depend on changed:
+ * the options, item type knowledge, or (since the Lua hook and the useless
+ * and forbidden prefixes look at the player) the turn.
+ */
+static void _check_autopickup_cache()
+{
+    static unsigned options_generation = 0;
+    static unsigned ident_epoch = 0;
+    static int turn = -1;
+
+    if (options_generation != Options.autopickup_generation
+        || ident_epoch != identification_epoch()
+        || turn != you.num_turns)
+    {
+        _autopickup_cache.clear();
+        options_generation = Options.autopickup_generation;
+        ident_epoch = identification_epoch();
+        turn = you.num_turns;
+    }
+}
+
+/// Artefacts, corpses and items with properties are named by more than the
+/// cache key knows about.
+static bool _autopickup_cacheable(const item_def &item)
+{
+    return !is_artefact(item)
+           && item.base_type != OBJ_CORPSES
+           && item.props.empty();
+}
+
+static bool _lua_or_option_autopickup(const item_def &item)
+{
     // the special-cased gold here is because this call can become very heavy
     // for gozag players under extreme circumstances
     const string iname = item.base_type == OBJ_GOLD
@@ -2902,6 +2967,37 @@ static bool _is_option_autopickup(const item_def &item, bool ignore_force)
     return Options.autopickups[item.base_type];
 }
 
+static bool _is_option_autopickup(const item_def &item, bool ignore_force)
+{
+    if (item.base_type < NUM_OBJECT_CLASSES)
+    {
+        const int force = item_autopickup_level(item);
+        if (!ignore_force && force != AP_FORCE_NONE)
+            return force == AP_FORCE_ON;
+    }
+    else
+        return false;
+
+    if (!_autopickup_cacheable(item))
+        return _lua_or_option_autopickup(item);
+
+    _check_autopickup_cache();
+    const autopickup_key key(item);
+    auto cached = _autopickup_cache.find(key);
+    if (cached != _autopickup_cache.end())
+        return cached->second;
+
+    const bool pickup = _lua_or_option_autopickup(item);
+    // Keep reporting a broken hook rather than hiding it behind the cache.
+    if (clua.error.empty())
+    {
+        if (_autopickup_cache.size() >= MAX_AUTOPICKUP_CACHE)
+            _autopickup_cache.clear();
+        _autopickup_cache[key] = pickup;
+    }
+    return pickup;
+}
+
 /** Is the item something that we should try to autopickup?
  *
  * @param ignore_force If true, ignore force_autopickup settings from the
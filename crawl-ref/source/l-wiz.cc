@@ -42,6 +42,10 @@ LUAFN(wiz_quick_fsim)
     PLUARET(number, fdata.player.av_eff_dam);
 }
 
+// Runs the full simulator (&F, or &^F with a true argument) as configured by
+// the fsim_* options.
+LUAWRAP(wiz_fight_sim, wizard_fight_sim(lua_toboolean(ls, 1)))
+
 LUAWRAP(wiz_identify_all_items, wizard_identify_all_items())
 
 LUAWRAP(wiz_map_level, wizard_map_level())
@@ -49,6 +53,7 @@ LUAWRAP(wiz_map_level, wizard_map_level())
 static const struct luaL_reg wiz_dlib[] =
 {
 { "quick_fsim", wiz_quick_fsim },
+{ "fight_sim", wiz_fight_sim },
 { "identify_all_items", wiz_identify_all_items},
 { "map_level", wiz_map_level},
 { nullptr, nullptr }
@@ -20,6 +20,7 @@
 
 #include <cassert>
 #include <cctype>
+#include <cinttypes>
 #include <clocale>
 #include <cstdarg>
 #include <cstdio>
@@ -34,6 +35,8 @@
 #include "colour.h"
 #include "cio.h"
 #include "crash.h"
+#include "dbg-replay.h"
+#include "screen-shadow.h"
 #include "state.h"
 #include "tiles-build-specific.h"
 #include "unicode.h"
@@ -468,6 +471,101 @@ static int proc_mouse_event(int c, const MEVENT *me)
 }
 #endif
 
+// DEC private mode 2026: the term holds off drawing between these.
+#define BEGIN_SYNCHRONIZED_UPDATE "\033[?2026h"
+#define END_SYNCHRONIZED_UPDATE "\033[?2026l"
+
+static unsigned long _frames_sent = 0;
+static uint64_t _frame_bytes_total = 0;
+static uint64_t _frame_bytes_max = 0;
+
+/**
+ * @internal
+ * How many bytes this process has written, as far as the OS can tell us;
+ * used for terminal_output_stats.
+ */
+static uint64_t _bytes_written()
+{
+#ifdef __linux__
+    FILE *io = fopen("/proc/self/io", "r");
+    if (!io)
+        return 0;
+
+    char line[80];
+    uint64_t bytes = 0;
+    while (fgets(line, sizeof(line), io))
+        if (sscanf(line, "wchar: %" SCNu64, &bytes) == 1)
+            break;
+    fclose(io);
+    return bytes;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @internal
+ * Send everything drawn since the last call to the term, wrapped in
+ * synchronized output brackets if wanted, and count the bytes it took.
+ */
+static void _refresh_screen()
+{
+    const bool sync = Options.synchronized_output && is_wintouched(stdscr);
+    const bool stats = Options.terminal_output_stats;
+    const uint64_t before = stats ? _bytes_written() : 0;
+
+    if (sync)
+    {
+        printf(BEGIN_SYNCHRONIZED_UPDATE);
+        fflush(stdout);
+    }
+    refresh();
+    if (sync)
+    {
+        printf(END_SYNCHRONIZED_UPDATE);
+        fflush(stdout);
+    }
+
+    if (stats)
+    {
+        const uint64_t bytes = _bytes_written() - before;
+        if (bytes)
+        {
+            _frames_sent++;
+            _frame_bytes_total += bytes;
+            _frame_bytes_max = max(_frame_bytes_max, bytes);
+        }
+    }
+}
+
+// What puttext() drew last, to diff the next view against.
+static screen_shadow _view_shadow;
+
+static bool _screen_update_pending = false;
+static int _updates_since_keyframe = 0;
+// Never drawn, so reading keys through it never refreshes the screen.
+static WINDOW *_key_window = nullptr;
+
+/**
+ * @internal
+ * With batch_screen_updates, send the screen that update_screen() held
+ * back, redrawing it from scratch every screen_keyframe_interval updates.
+ */
+static void _send_batched_update()
+{
+    if (!_screen_update_pending)
+        return;
+    _screen_update_pending = false;
+
+    if (Options.screen_keyframe_interval > 0
+        && ++_updates_since_keyframe >= Options.screen_keyframe_interval)
+    {
+        clearok(curscr, TRUE);
+        _updates_since_keyframe = 0;
+    }
+    _refresh_screen();
+}
+
 static int pending = 0;
 
 static int _get_key_from_curses()
@@ -487,6 +585,8 @@ static int _get_key_from_curses()
 
     wint_t c;
 
+    _send_batched_update();
+
 #ifdef USE_TILE_WEB
     refresh();
 
@@ -529,7 +629,7 @@ void set_getch_returns_resizes(bool rr)
     getch_returns_resizes = rr;
 }
 
-int getch_ck()
+static int _getch_ck()
 {
     while (true)
     {
@@ -590,6 +690,16 @@ int getch_ck()
     }
 }
 
+int getch_ck()
+{
+    if (key_replay_active())
+        return key_replay_next();
+
+    const int c = _getch_ck();
+    key_record(c);
+    return c;
+}
+
 static void unix_handle_terminal_resize()
 {
     console_shutdown();
@@ -710,6 +820,7 @@ void console_startup()
     initscr();
     raw();
     noecho();
+    _view_shadow.resize(LINES, COLS);
 
     nonl();
     intrflush(stdscr, FALSE);
@@ -735,6 +846,16 @@ void console_startup()
 
     scrollok(stdscr, FALSE);
 
+    _key_window = newwin(1, 1, 0, 0);
+    if (_key_window)
+    {
+#ifdef CURSES_USE_KEYPAD
+        keypad(_key_window, TRUE);
+#endif
+        meta(_key_window, TRUE);
+        nodelay(_key_window, TRUE);
+    }
+
     // Must call refresh() for ncurses to update COLS and LINES.
     refresh();
     crawl_view.init_geometry();
@@ -751,6 +872,12 @@ void console_startup()
 
 void console_shutdown()
 {
+    _send_batched_update();
+    if (_key_window)
+    {
+        delwin(_key_window);
+        _key_window = nullptr;
+    }
     // resetty();
     endwin();
 
@@ -765,6 +892,14 @@ void console_shutdown()
     signal(SIGWINCH, SIG_DFL);
 # endif
 #endif
+
+    if (Options.terminal_output_stats && _frames_sent)
+    {
+        fprintf(stderr, "Terminal output: %lu screen updates, %" PRIu64
+                " bytes each on average, %" PRIu64 " at most.\n",
+                _frames_sent, _frame_bytes_total / _frames_sent,
+                _frame_bytes_max);
+    }
 }
 
 void cprintf(const char *format, ...)
@@ -791,8 +926,14 @@ void putwch(char32_t chr)
     wchar_t c = chr;
     if (!c)
         c = ' ';
+    int y, x;
+    getyx(stdscr, y, x);
     // TODO: recognize unsupported characters and try to transliterate
     addnwstr(&c, 1);
+    // Every cell up to the new cursor was written: two for a wide glyph,
+    // and the rest of the row if it wrapped.
+    const int end = getcury(stdscr) == y ? max(getcurx(stdscr), x + 1) : COLS;
+    _view_shadow.forget(y, x, end);
 
 #ifdef USE_TILE_WEB
     char32_t buf[2];
@@ -806,15 +947,66 @@ void puttext(int x1, int y1, const crawl_view_buffer &vbuf)
 {
     const screen_cell_t *cell = vbuf;
     const coord_def size = vbuf.size();
+
+#ifdef USE_TILE_WEB
+    // The web text layers are fed through putwch(), so they need every cell.
+    // Console players of a webtiles build have no such layers.
+    if (tiles.is_controlled_from_web())
+    {
+        for (int y = 0; y < size.y; ++y)
+        {
+            cgotoxy(x1, y1 + y);
+            for (int x = 0; x < size.x; ++x)
+            {
+                put_colour_ch(cell->colour, cell->glyph);
+                cell++;
+            }
+        }
+        return;
+    }
+#endif
+
+    // Most of the view is the same from one turn to the next. Leave cells
+    // that still show what was last drawn there alone, so that curses
+    // neither redoes the work of adding them nor has to compare them again
+    // when refreshing.
+    if (!_view_shadow.has_size(LINES, COLS))
+        _view_shadow.resize(LINES, COLS);
+
+    curses_style style = { 0, 0 };
     for (int y = 0; y < size.y; ++y)
     {
-        cgotoxy(x1, y1 + y);
-        for (int x = 0; x < size.x; ++x)
+        const int row = y1 + y - 1;
+        bool in_place = false;
+        for (int x = 0; x < size.x; ++x, ++cell)
         {
-            put_colour_ch(cell->colour, cell->glyph);
-            cell++;
+            const int col = x1 + x - 1;
+            style = curs_attr_fg(cell->colour);
+            if (!_view_shadow.draw(row, col, cell->glyph, style.attr,
+                                   style.color_pair))
+            {
+                in_place = false;
+                continue;
+            }
+
+            if (!in_place)
+                move(row, col);
+            attr_set(style.attr, style.color_pair, nullptr);
+            const wchar_t c = cell->glyph ? cell->glyph : ' ';
+            addnwstr(&c, 1);
+
+            // A wide glyph covers the next cell too, which must be redrawn.
+            in_place = getcurx(stdscr) == col + 1;
+            if (!in_place)
+                _view_shadow.forget(row, col + 1, col + 2);
         }
     }
+    // Leave the cursor and colour where drawing every cell would have.
+    if (size.x > 0 && size.y > 0)
+    {
+        move(y1 + size.y - 2, x1 + size.x - 1);
+        attr_set(style.attr, style.color_pair, nullptr);
+    }
 }
 
 // These next four are front functions so that we can reduce
@@ -829,7 +1021,10 @@ void update_screen()
     {
         // Refreshing the default colors helps keep colors synced in ttyrecs.
         curs_set_default_colors();
-        refresh();
+        if (Options.batch_screen_updates)
+            _screen_update_pending = true;
+        else
+            _refresh_screen();
     }
 
 #ifdef USE_TILE_WEB
@@ -841,6 +1036,7 @@ void clear_to_end_of_line()
 {
     textcolour(LIGHTGREY);
     textbackground(BLACK);
+    _view_shadow.forget(getcury(stdscr), getcurx(stdscr), COLS);
     clrtoeol();
 
 #ifdef USE_TILE_WEB
@@ -886,6 +1082,7 @@ void clrscr_sys()
     textcolour(LIGHTGREY);
     textbackground(BLACK);
     clear();
+    _view_shadow.forget_all();
 #ifdef DGAMELAUNCH
     if (!_suppress_dgl_clrscr)
     {
@@ -1443,6 +1640,7 @@ static void write_char_at(int y, int x, const cchar_t &ch)
 
     attr_set(attr, color_pair, nullptr);
     mvadd_wchnstr(y, x, &ch, 1);
+    _view_shadow.forget(y, x, x + 1);
 }
 
 // see declaration
@@ -1566,12 +1764,20 @@ void delay(unsigned int time)
     tiles.redraw();
     if (time)
     {
+        tiles.flush_frame_updates();
         tiles.send_message("{\"msg\":\"delay\",\"t\":%d}", time);
         tiles.flush_messages();
     }
 #endif
 
-    refresh();
+    // Nobody is watching frame by frame.
+    if (Options.batch_screen_updates)
+    {
+        _screen_update_pending = true;
+        return;
+    }
+
+    _refresh_screen();
     if (time)
         usleep(time * 1000);
 }
@@ -1579,6 +1785,10 @@ void delay(unsigned int time)
 /* This is Juho Snellman's modified kbhit, to work with macros */
 bool kbhit()
 {
+    // Replayed keys are all "typed" before the game asks for them.
+    if (key_replay_active())
+        return false;
+
     if (pending)
         return true;
 
@@ -1586,10 +1796,22 @@ bool kbhit()
 #ifndef USE_TILE_WEB
     int i;
 
-    nodelay(stdscr, TRUE);
-    timeout(0);  // apparently some need this to guarantee non-blocking -- bwr
-    i = get_wch(&c);
-    nodelay(stdscr, FALSE);
+    // Asking curses through stdscr would also refresh the screen, which is
+    // just what batching wants to avoid. The key window sees the same keys,
+    // including any curses has already read ahead, but is never drawn.
+    if (Options.batch_screen_updates && _key_window)
+    {
+        untouchwin(_key_window);
+        i = wget_wch(_key_window, &c);
+    }
+    else
+    {
+        nodelay(stdscr, TRUE);
+        // apparently some need this to guarantee non-blocking -- bwr
+        timeout(0);
+        i = get_wch(&c);
+        nodelay(stdscr, FALSE);
+    }
 
     switch (i)
     {
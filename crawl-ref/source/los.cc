@@ -50,6 +50,7 @@
 #include "areas.h"
 #include "coord.h"
 #include "coordit.h"
+#include "dbg-prof.h"
 #include "env.h"
 #include "losglobal.h"
 #include "mon-act.h"
@@ -863,6 +864,8 @@ struct los_param_funcs : public los_param
 void losight(los_grid& sh, const coord_def& center,
              const opacity_func& opc, const circle_def& bounds)
 {
+    prof_timer timer(PROF_LOS);
+
     const los_param& dat = los_param_funcs(center, opc, bounds);
 
     sh.init(false);
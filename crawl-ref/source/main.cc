@@ -50,6 +50,9 @@
 #include "corpse.h"
 #include "crash.h"
 #include "database.h"
+#include "dbg-alloc.h"
+#include "dbg-prof.h"
+#include "dbg-replay.h"
 #include "dbg-scan.h"
 #include "dbg-util.h"
 #include "delay.h"
@@ -512,6 +515,16 @@ static void _show_commandline_options_help()
     puts("  -throttle             enable throttling of user Lua scripts");
     puts("  -seed <number>        specify a game seed to use when creating a new game");
 #endif
+    puts("  -record-keys <file>   log every keystroke to <file>");
+    puts("  -replay-keys <file>   play back a -record-keys log instead of reading");
+    puts("                        the keyboard, then report command latencies");
+    puts("  -mem-report           write memory use by subsystem to the morgue");
+    puts("                        directory on exit");
+    puts("  -lua-profile          time Lua functions and write the results to the");
+    puts("                        morgue directory on exit");
+    puts("  -trace <file>         write a trace of monster turns, spells, Lua,");
+    puts("                        level saves and generation to <file>, for");
+    puts("                        viewing in chrome://tracing or Perfetto");
 
     puts("");
 
@@ -533,6 +546,8 @@ static void _show_commandline_options_help()
     puts("");
     puts("Arena options: (Stage a tournament between various monsters.)");
     puts("  -arena \"<monster list> v <monster list> arena:<arena map>\"");
+    puts("  -arena-jobs <num>  run the -arena fights without a display, split");
+    puts("                     over <num> processes; see arena.json, arena.tsv");
 #ifdef DEBUG_DIAGNOSTICS
     puts("");
     puts("Diagnostic options:");
@@ -558,6 +573,11 @@ static void _show_commandline_options_help()
     puts("      Defaults to entire dungeon; same level syntax as -mapstat.");
     puts("  -iters <num>        For -mapstat and -objstat, set the number of "
          "iterations");
+    puts("  -stat-jobs <num>    For -mapstat and -objstat, split the iterations "
+         "over");
+    puts("      <num> worker processes; results match a single-process run "
+         "with the");
+    puts("      same -seed.");
     puts("  -force-map <map>    For -mapstat and -objstat, alway choose the "
          "      given map on every level.");
 #endif
@@ -717,6 +737,7 @@ static void _set_removed_types_as_identified()
     for (auto entry : removed_items)
         if (item_type_has_ids(entry.first))
             you.type_ids(entry) = true;
+    item_type_knowledge_changed();
 }
 
 // Set up the running variables for the current run.
@@ -1142,6 +1163,7 @@ static void _input()
         cursor_control con(false);
 #endif
         const command_type cmd = you.turn_is_over ? CMD_NO_CMD : _get_next_cmd();
+        key_replay_command(cmd);
 
         if (crawl_state.seen_hups)
             save_game(true, "Game saved, see you later!");
@@ -2299,6 +2321,8 @@ static void _update_still_winds()
 
 void world_reacts()
 {
+    prof_timer timer(PROF_WORLD_REACTS);
+
     // All markers should be activated at this point.
     ASSERT(!env.markers.need_activate());
 
@@ -2383,6 +2407,10 @@ void world_reacts()
     viewwindow();
     update_screen();
 
+    // Read the level the stairs lead to while the player decides.
+    if (feat_is_travelable_stair(env.grid(you.pos())))
+        prefetch_level(level_id::get_next_level_id(you.pos()));
+
     if (you.cannot_act() && any_messages()
         && crawl_state.repeat_cmd != CMD_WIZARD)
     {
@@ -2405,6 +2433,11 @@ void world_reacts()
             env.turns_on_level++;
         record_turn_timestamp();
         update_turn_count();
+        if (Options.mem_sample_turns
+            && !(you.num_turns % Options.mem_sample_turns))
+        {
+            alloc_sample();
+        }
         msgwin_new_turn();
         crawl_state.lua_calls_no_turn = 0;
         if (crawl_state.game_is_sprint()
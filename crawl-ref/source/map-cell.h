@@ -1,5 +1,6 @@
 #pragma once
 
+#include "dbg-alloc.h"
 #include "enum.h"
 #include "mon-info.h"
 #include "tag-version.h"
@@ -70,6 +71,7 @@ struct map_cell
 
     map_cell(const map_cell& c)
     {
+        alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
         memcpy(this, &c, sizeof(map_cell));
         if (_cloud)
             _cloud = new cloud_info(*_cloud);
@@ -93,6 +95,7 @@ struct map_cell
     {
         if (&c == this)
             return *this;
+        alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
         if (_cloud)
             delete _cloud;
         if (_mons)
@@ -173,6 +176,7 @@ struct map_cell
 
     void set_item(const item_info& ii, bool more_items)
     {
+        alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
         clear_item();
         _item = new item_info(ii);
         if (more_items)
@@ -206,6 +210,7 @@ struct map_cell
 
     void set_monster(const monster_info& mi)
     {
+        alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
         clear_monster();
         _mons = new monster_info(mi);
     }
@@ -222,6 +227,7 @@ struct map_cell
 
     void set_detected_monster(monster_type mons)
     {
+        alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
         clear_monster();
         _mons = new monster_info(MONS_SENSED);
         _mons->base_type = mons;
@@ -265,6 +271,7 @@ struct map_cell
 
     void set_cloud(const cloud_info& ci)
     {
+        alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
         if (_cloud)
             delete _cloud;
         _cloud = new cloud_info(ci);
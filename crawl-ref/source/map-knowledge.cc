@@ -170,6 +170,7 @@ void clear_terrain_visibility()
 
 void map_cell::set_detected_item()
 {
+    alloc_scope scope(ALLOC_MAP_KNOWLEDGE);
     clear_item();
     flags |= MAP_DETECTED_ITEM;
     _item = new item_info();
@@ -20,6 +20,9 @@
 #include "cluautil.h"
 #include "colour.h"
 #include "coordit.h"
+#include "dbg-alloc.h"
+#include "dbg-maps.h"
+#include "dbg-trace.h"
 #include "describe.h"
 #include "dgn-height.h"
 #include "dungeon.h"
@@ -2464,6 +2467,8 @@ void map_def::load()
     if (!index_only)
         return;
 
+    alloc_scope scope(ALLOC_VAULTS);
+
     const string descache_base = get_descache_path(cache_name, "");
     file_lock deslock(descache_base + ".lk", "rb", false);
     const string loadfile = descache_base + ".dsc";
@@ -2575,6 +2580,13 @@ void map_def::set_file(const string &s)
 
 string map_def::run_lua(bool run_main)
 {
+    trace_span span("map lua", "run_lua");
+    if (span.active())
+        span.set_detail(name);
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_MAP_LUA, name);
+#endif
+
     dlua_set_map mset(this);
 
     int err = prelude.load(dlua);
@@ -2632,6 +2644,16 @@ void map_def::copy_hooks_from(const map_def &other_map, const string &hook_name)
 // no errors occurred while running hooks.
 bool map_def::run_hook(const string &hook_name, bool die_on_lua_error)
 {
+    trace_span span("map lua", "hook");
+    if (span.active())
+    {
+        span.set_label(hook_name);
+        span.set_detail(name);
+    }
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_MAP_LUA, name);
+#endif
+
     const dlua_set_map mset(this);
     if (!dlua.callfn("dgn_map_run_hook", "s", hook_name.c_str()))
     {
@@ -2664,6 +2686,9 @@ bool map_def::run_postplace_hook(bool die_on_lua_error)
 bool map_def::test_lua_boolchunk(dlua_chunk &chunk, bool defval,
                                  bool die_on_lua_error)
 {
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_MAP_LUA, name);
+#endif
     bool result = defval;
     dlua_set_map mset(this);
 
@@ -12,6 +12,7 @@
 #include "beh-type.h"
 #include "cluautil.h"
 #include "coordit.h"
+#include "dbg-trace.h"
 #include "dlua.h"
 #include "end.h"
 #include "env.h"
@@ -329,6 +330,10 @@ void map_lua_marker::push_fn_args(const char *fn) const
 
 bool map_lua_marker::callfn(const char *fn, bool warn_err, int args) const
 {
+    trace_span span("map lua", fn);
+    if (span.active())
+        span.set_detail("marker");
+
     if (args == -1)
     {
         const int top = lua_gettop(dlua);
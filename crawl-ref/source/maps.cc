@@ -19,6 +19,7 @@
 #include "branch.h"
 #include "coord.h"
 #include "coordit.h"
+#include "dbg-alloc.h"
 #include "dbg-maps.h"
 #include "dungeon.h"
 #include "end.h"
@@ -105,6 +106,7 @@ map_section_type vault_main(vault_placement &place, const map_def *vault,
                             bool check_place)
 {
 #ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_VAULT, vault->name);
     if (crawl_state.map_stat_gen)
         mapstat_report_map_try(*vault);
 #endif
@@ -599,6 +601,10 @@ static bool _apply_vault_grid(map_def &def,
                               vault_placement &place,
                               bool check_place)
 {
+#ifdef DEBUG_STATISTICS
+    mapstat_timer timer(MST_VAULT_FIT, def.name);
+#endif
+
     const map_lines &ml = def.map;
     const int orient = def.orient;
 
@@ -1483,6 +1489,7 @@ void read_map(const string &file)
 
 void read_maps()
 {
+    alloc_scope scope(ALLOC_VAULTS);
     if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
         end(1, false, "Lua error: %s", dlua.error.c_str());
 
@@ -1524,6 +1531,7 @@ void dump_map(const map_def &map)
 
 void add_parsed_map(const map_def &md)
 {
+    alloc_scope scope(ALLOC_VAULTS);
     map_def map = md;
 
     map.fixup();
@@ -7,6 +7,7 @@
 
 #include "message.h"
 
+#include <map>
 #include <sstream>
 
 #include "areas.h"
@@ -1344,15 +1345,165 @@ void dprf(diag_type param, const char *format, ...)
 
 static bool _updating_view = false;
 
+// Can this regex be one alternative of a bigger one and still mean the
+// same thing? Backreferences, recursion, conditionals and (*VERB)s might
+// not, so be conservative about anything like them.
+static bool _pattern_combines(const string &pat)
+{
+    for (size_t i = 0; i + 1 < pat.size(); ++i)
+    {
+        if (pat[i] == '\\')
+        {
+            const char c = pat[++i];
+            if ((isadigit(c) && c != '0') || c == 'g' || c == 'k')
+                return false;
+        }
+        else if (pat[i] == '(' && pat[i + 1] == '*')
+            return false;
+        else if (pat[i] == '(' && pat[i + 1] == '?'
+                 && (i + 2 >= pat.size() || !strchr(":=!<>#imsx-", pat[i + 2])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * A list of message filters compiled for matching many messages against.
+ *
+ * For each channel, the patterns that apply to it are joined into one
+ * alternation (one per case sensitivity), so that a message matching none
+ * of them, the usual case, costs one or two regex matches however long the
+ * list is. Only when that succeeds are the filters tried one by one, to
+ * find which matched first. Results are remembered for messages that come
+ * up again.
+ */
+class message_filter_matcher
+{
+public:
+    message_filter_matcher() : ready(false), generation(0) { }
+
+    bool needs_rebuild(unsigned gen) const
+    {
+        return !ready || gen != generation;
+    }
+
+    void rebuild(const vector<message_filter> &list, unsigned gen)
+    {
+        filters = list;
+        for (channel_set &cs : channels)
+            cs = channel_set();
+        memo.clear();
+        generation = gen;
+        ready = true;
+    }
+
+    /// The index of the first filter matching the message, or -1.
+    int first_match(msg_channel_type channel, const string &line)
+    {
+        const channel_set &cs = channel_filters(channel);
+        if (cs.candidates.empty())
+            return -1;
+
+        const pair<int, string> key(channel, line);
+        auto seen = memo.find(key);
+        if (seen != memo.end())
+            return seen->second;
+
+        bool may_match = cs.always_scan;
+        for (const text_pattern &pat : cs.combined)
+            if (!may_match)
+                may_match = pat.matches(line);
+
+        int result = -1;
+        if (may_match)
+        {
+            for (int i : cs.candidates)
+                if (filters[i].is_filtered(channel, line))
+                {
+                    result = i;
+                    break;
+                }
+        }
+
+        if (memo.size() >= MAX_MEMO)
+            memo.clear();
+        memo[key] = result;
+        return result;
+    }
+
+private:
+    struct channel_set
+    {
+        bool built = false;
+        bool always_scan = false;     // some filter can't be combined
+        vector<int> candidates;       // filters for this channel, in order
+        vector<text_pattern> combined;
+    };
+
+    const channel_set &channel_filters(msg_channel_type channel)
+    {
+        channel_set &cs = channels[channel];
+        if (cs.built)
+            return cs;
+        cs.built = true;
+
+        string joined[2]; // case sensitive, ignoring case
+        for (int i = 0; i < (int) filters.size(); ++i)
+        {
+            const message_filter &mf = filters[i];
+            if (mf.channel != channel && mf.channel != -1)
+                continue;
+
+            const text_pattern &pat = mf.pattern;
+            if (pat.empty() || !_pattern_combines(pat.tostring()))
+                cs.always_scan = true;
+            else if (!pat.valid())
+                continue; // never matches anything
+            else
+            {
+                string &alts = joined[pat.ignores_case()];
+                if (!alts.empty())
+                    alts += "|";
+                alts += "(" + pat.tostring() + ")";
+            }
+            cs.candidates.push_back(i);
+        }
+
+        for (int icase = 0; icase < 2; ++icase)
+        {
+            if (joined[icase].empty())
+                continue;
+            cs.combined.emplace_back(joined[icase], icase);
+            if (!cs.combined.back().valid())
+                cs.always_scan = true;
+        }
+        return cs;
+    }
+
+    static const size_t MAX_MEMO = 1024;
+
+    bool ready;
+    unsigned generation;
+    vector<message_filter> filters;
+    channel_set channels[NUM_MESSAGE_CHANNELS];
+    map<pair<int, string>, int> memo;
+};
+
+static message_filter_matcher _force_more_matcher;
+static message_filter_matcher _flash_screen_matcher;
+static message_filter_matcher _message_colour_matcher;
+
 static bool _check_option(const string& line, msg_channel_type channel,
-                          const vector<message_filter>& option)
+                          const vector<message_filter>& option,
+                          message_filter_matcher &matcher)
 {
     if (crawl_state.generating_level)
         return false;
-    return any_of(begin(option),
-                  end(option),
-                  bind(mem_fn(&message_filter::is_filtered),
-                       placeholders::_1, channel, line));
+    if (matcher.needs_rebuild(Options.message_filter_generation))
+        matcher.rebuild(option, Options.message_filter_generation);
+    return matcher.first_match(channel, line) >= 0;
 }
 
 static bool _check_more(const string& line, msg_channel_type channel)
@@ -1362,7 +1513,8 @@ static bool _check_more(const string& line, msg_channel_type channel)
     // crash here in order to find the real bug?
     if (!you.on_current_level)
         return false;
-    return _check_option(line, channel, Options.force_more_message);
+    return _check_option(line, channel, Options.force_more_message,
+                         _force_more_matcher);
 }
 
 static bool _check_flash_screen(const string& line, msg_channel_type channel)
@@ -1372,7 +1524,8 @@ static bool _check_flash_screen(const string& line, msg_channel_type channel)
     // crash here in order to find the real bug?
     if (!you.on_current_level)
         return false;
-    return _check_option(line, channel, Options.flash_screen_message);
+    return _check_option(line, channel, Options.flash_screen_message,
+                         _flash_screen_matcher);
 }
 
 static bool _check_join(const string& /*line*/, msg_channel_type channel)
@@ -1801,14 +1954,21 @@ static msg_colour_type prepare_message(const string& imsg,
 
     if (!crawl_state.generating_level)
     {
-        for (const message_colour_mapping &mcm : Options.message_colour_mappings)
+        const unsigned gen = Options.message_filter_generation;
+        if (_message_colour_matcher.needs_rebuild(gen))
         {
-            if (mcm.message.is_filtered(channel, imsg))
+            vector<message_filter> filters;
+            for (const message_colour_mapping &mcm
+                 : Options.message_colour_mappings)
             {
-                colour = mcm.colour;
-                break;
+                filters.push_back(mcm.message);
             }
+            _message_colour_matcher.rebuild(filters, gen);
         }
+
+        const int mapping = _message_colour_matcher.first_match(channel, imsg);
+        if (mapping >= 0)
+            colour = Options.message_colour_mappings[mapping].colour;
     }
 
     return colour;
@@ -16,7 +16,9 @@
 #include "colour.h"
 #include "coordit.h"
 #include "corpse.h"
+#include "dbg-prof.h"
 #include "dbg-scan.h"
+#include "dbg-trace.h"
 #include "delay.h"
 #include "directn.h" // feature_description_at
 #include "dungeon.h"
@@ -1527,7 +1529,12 @@ static void _pre_monster_move(monster& mons)
 
 void handle_monster_move(monster* mons)
 {
+    prof_timer timer(PROF_MONSTER_MOVE);
+    trace_span span("monster", "monster turn");
+
     ASSERT(mons); // XXX: change to monster &mons
+    if (span.active())
+        span.set_label(mons_type_name(mons->type, DESC_PLAIN));
     const monsterentry* entry = get_monster_data(mons->type);
     if (!entry)
         return;
@@ -2373,6 +2380,8 @@ static void _display_just_seen()
  */
 void handle_monsters(bool with_noise)
 {
+    prof_timer timer(PROF_MONSTERS);
+
     for (monster_iterator mi; mi; ++mi)
     {
         _pre_monster_move(**mi);
@@ -22,6 +22,7 @@
 #include "colour.h"
 #include "coordit.h"
 #include "database.h"
+#include "dbg-trace.h"
 #include "delay.h"
 #include "directn.h"
 #include "english.h"
@@ -2084,12 +2085,13 @@ static void _set_door(set<coord_def> door, dungeon_feature_type feat)
 static int _tension_door_closed(set<coord_def> door,
                                 dungeon_feature_type old_feat)
 {
-    // this unwind is a bit heavy, but because out-of-los clouds dissipate
-    // instantly, they can be wiped out by these door tests.
-    unwind_var<map<coord_def, cloud_struct>> cloud_state(env.cloud);
+    // because out-of-los clouds dissipate instantly, they can be wiped out
+    // by these door tests, so put them back afterwards.
+    const vector<cloud_struct> clouds = env.cloud.snapshot();
     _set_door(door, DNGN_CLOSED_DOOR);
     const int new_tension = get_tension(GOD_NO_GOD);
     _set_door(door, old_feat);
+    env.cloud.restore(clouds);
     return new_tension;
 }
 
@@ -3671,6 +3673,10 @@ static mon_spell_slot _choose_spell_to_cast(monster &mons,
                                             const monster_spells &hspell_pass,
                                             bool ignore_good_idea)
 {
+    // The same beams tend to get traced over and over while we make up our
+    // mind, and nothing moves until we do.
+    tracer_cache_scope tracer_cache;
+
     // Monsters caught in a net try to get away.
     // This is only urgent if enemies are around.
     // TODO this seems kind of pointless with a 1/15 chance?
@@ -5360,6 +5366,13 @@ static void _mons_tornado(monster *mons, bool is_vortex = false)
 void mons_cast(monster* mons, bolt pbolt, spell_type spell_cast,
                mon_spell_slot_flags slot_flags, bool do_noise)
 {
+    trace_span span("spell", "monster spell");
+    if (span.active())
+    {
+        span.set_label(spell_title(spell_cast));
+        span.set_detail(mons_type_name(mons->type, DESC_PLAIN));
+    }
+
     // check sputtercast state for e.g. orb spiders. assumption: all
     // sputtercasting monsters have one charge status and use it for all of
     // their spells.
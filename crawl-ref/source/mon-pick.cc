@@ -8,6 +8,8 @@
 #include "mon-pick.h"
 #include "mon-pick-data.h"
 
+#include <chrono>
+
 #include "branch.h"
 #include "coord.h"
 #include "env.h"
@@ -86,6 +88,8 @@ monster_type monster_picker::pick_with_veto(const pop_entry *weights,
                                             mon_pick_vetoer vetoer)
 {
     _veto = vetoer;
+    if (!can_veto())
+        return pick_cached(weights, level, none);
     return pick(weights, level, none);
 }
 
@@ -96,6 +100,11 @@ bool monster_picker::veto(monster_type mon)
     return _veto && (invalid_monster_type(mon) || _veto(mon));
 }
 
+bool monster_picker::can_veto() const
+{
+    return _veto != nullptr;
+}
+
 bool positioned_monster_picker::veto(monster_type mon)
 {
     // Actually pick a monster that is happy where we want to put it.
@@ -257,6 +266,54 @@ void debug_monpick()
         }
     }
 
+    // The cached tables must give exactly the same picks as a full scan of
+    // the population for the same rolls. Time both while we're at it.
+    const int picks_per_level = 200;
+    monster_picker picker;
+    vector<monster_type> scanned, cached;
+    chrono::nanoseconds scan_time(0), cache_time(0);
+    for (branch_iterator it; it; ++it)
+    {
+        branch_type br = it->id;
+
+        for (int d = 1; d <= branch_ood_cap(br); d++)
+        {
+            scanned.clear();
+            cached.clear();
+            const uint64_t seed = br * 1000 + d;
+
+            auto start = chrono::steady_clock::now();
+            {
+                rng::subgenerator pick_rng(seed);
+                for (int i = 0; i < picks_per_level; i++)
+                    scanned.push_back(picker.pick(population[br].pop, d, MONS_0));
+            }
+            scan_time += chrono::steady_clock::now() - start;
+
+            start = chrono::steady_clock::now();
+            {
+                rng::subgenerator pick_rng(seed);
+                for (int i = 0; i < picks_per_level; i++)
+                {
+                    cached.push_back(picker.pick_cached(population[br].pop, d,
+                                                        MONS_0));
+                }
+            }
+            cache_time += chrono::steady_clock::now() - start;
+
+            if (scanned != cached)
+            {
+                fails += make_stringf(
+                    "%s: cached monster picks differ from a full scan\n",
+                    level_id(br, d).describe().c_str());
+            }
+        }
+    }
+
+    fprintf(stderr, "mon-pick: scanned picks took %dms, cached picks %dms\n",
+            (int) chrono::duration_cast<chrono::milliseconds>(scan_time).count(),
+            (int) chrono::duration_cast<chrono::milliseconds>(cache_time).count());
+
     dump_test_fails(fails, "mon-pick");
 }
 #endif
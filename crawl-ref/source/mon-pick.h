@@ -19,6 +19,8 @@ int monster_probability(level_id place, monster_type m);
 int monster_pop_depth_avg(branch_type branch, monster_type m);
 
 monster_type pick_monster(level_id place, mon_pick_vetoer veto = nullptr);
+// fpop must be a static population list; unvetoed picks cache per-depth
+// tables keyed on its address.
 monster_type pick_monster_from(const pop_entry *fpop, int depth,
                                mon_pick_vetoer = nullptr);
 monster_type pick_monster_no_rarity(branch_type branch);
@@ -45,6 +47,7 @@ public:
                                 mon_pick_vetoer vetoer = nullptr);
 
     virtual bool veto(monster_type mon) override;
+    virtual bool can_veto() const override;
 
 private:
     mon_pick_vetoer _veto;
@@ -58,6 +61,7 @@ public:
         : monster_picker(), pos(_pos), posveto(_posveto) { };
 
     virtual bool veto(monster_type mon) override;
+    virtual bool can_veto() const override { return true; }
 
 protected:
     const coord_def &pos;
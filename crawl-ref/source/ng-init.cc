@@ -461,6 +461,9 @@ void initialise_item_descriptions()
             }
         }
     }
+
+    // Unidentified item names are built from these.
+    item_type_knowledge_changed();
 }
 
 void fix_up_jiyva_name()
@@ -113,7 +113,8 @@ public:
     // Propagate noise from the noise sources registered.
     void propagate_noise();
 
-    // Clear all noise from the noise grid.
+    // Clear all noise from the noise grid. Only touches the cells that
+    // noise has reached since the last reset.
     void reset();
 
     bool dirty() const { return !noises.empty(); }
@@ -125,6 +126,9 @@ public:
 #endif
 
 private:
+    bool apply_noise_at(const coord_def &pos, int noise_intensity_millis,
+                        int noise_id, int travel_distance,
+                        const coord_def &neighbour_delta);
     bool propagate_noise_to_neighbour(int base_attenuation,
                                       int travel_distance,
                                       const noise_cell &cell,
@@ -141,5 +145,7 @@ private:
 private:
     FixedArray<noise_cell, GXM, GYM> cells;
     vector<noise_t> noises;
+    vector<coord_def> touched;
+    vector<coord_def> noise_perimeter[2];
     int affected_actor_count;
 };
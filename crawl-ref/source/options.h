@@ -401,6 +401,14 @@ public:
     string sound_file_path;
     vector<colour_mapping> menu_colour_mappings;
     vector<message_colour_mapping> message_colour_mappings;
+    // Changes whenever force_more_message, flash_screen_message or
+    // message_colour_mappings might have, so that compiled matchers for
+    // them know to rebuild.
+    unsigned message_filter_generation;
+    // Changes whenever autopickups, force_autopickup or the rc Lua (which
+    // may add autopickup functions) might have, so that cached autopickup
+    // decisions are thrown away.
+    unsigned autopickup_generation;
 
     vector<menu_sort_condition> sort_menus;
 
@@ -436,6 +444,8 @@ public:
                                     // a name set on game start
     bool        read_persist_options; // If true, Crawl will try to load
                                       // options from c_persist.options
+    bool        turn_profile; // Time the phases of each turn
+    int         mem_sample_turns; // Log memory use every this many turns
 
     vector<text_pattern> drop_filter;
 
@@ -452,6 +462,12 @@ public:
     bool        use_fake_cursor;    // Draw a fake cursor instead of relying
                                     // on the term's own cursor.
     bool        use_fake_player_cursor;
+    bool        synchronized_output; // Bracket each screen update so the
+                                     // term shows it all at once.
+    bool        terminal_output_stats; // Report bytes per screen update.
+    bool        batch_screen_updates; // Only draw when waiting for input.
+    int         screen_keyframe_interval; // Full redraw every this many
+                                          // batched updates.
 
     bool        show_player_species;
 
@@ -494,6 +510,8 @@ public:
     string      fsim_mode;
     bool        fsim_csv;
     int         fsim_rounds;
+    int         fsim_precision;
+    int         fsim_jobs;
     string      fsim_mons;
     vector<string> fsim_scale;
     vector<string> fsim_kit;
@@ -632,6 +650,8 @@ private:
     void add_message_colour_mappings(const string &, bool, bool);
     void add_message_colour_mapping(const string &, bool, bool);
     message_filter parse_message_filter(const string &s);
+    void message_filters_changed();
+    void autopickup_options_changed();
 
     void set_default_activity_interrupts();
     void set_activity_interrupt(FixedBitVector<NUM_ACTIVITY_INTERRUPTS> &eints,
@@ -22,6 +22,7 @@ Notes:
 
 #include "package.h"
 
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -38,6 +39,9 @@ Notes:
 #include "errors.h"
 #include "syscalls.h"
 #include "libutil.h" // map_find
+#ifdef UNIX
+#include "threads.h"
+#endif
 
 // debugging defines
 #undef  FSCK_VERBOSE
@@ -76,6 +80,30 @@ struct block_header
     plen_t next;
 };
 
+#if defined(UNIX) && defined(USE_ZLIB)
+// Chunks are read ahead with pread(), which doesn't disturb the file offset
+// the rest of the package relies on.
+#define PREFETCH_CHUNKS
+#endif
+
+// A chunk being read and inflated on another thread. The thread touches only
+// this and the save's descriptor, and allocates with malloc(), since the
+// debugging allocation counters behind operator new aren't thread-safe.
+struct chunk_prefetch
+{
+    string name;
+    plen_t start;
+    int fd;
+    plen_t file_len;
+#ifdef PREFETCH_CHUNKS
+    thread_t thread;
+#endif
+    atomic<bool> cancelled;
+    unsigned char *data;
+    size_t len;
+    bool ok;
+};
+
 typedef map<string, plen_t> directory_t;
 typedef pair<plen_t, plen_t> bm_p;
 typedef map<plen_t, bm_p> bm_t;
@@ -86,6 +114,7 @@ package::package(const char* file, bool writeable, bool empty)
 #ifdef DO_FSYNC
     , tmp(false)
 #endif
+    , prefetching(nullptr)
 {
     dprintf("package: initializing file=\"%s\" rw=%d\n", file, writeable);
     ASSERT(writeable || !empty);
@@ -136,6 +165,7 @@ package::package()
 #ifdef DO_FSYNC
     , tmp(true)
 #endif
+    , prefetching(nullptr)
 {
     dprintf("package: initializing tmp file\n");
     filename = "[tmp]";
@@ -208,6 +238,7 @@ void package::load_traces()
 package::~package()
 {
     dprintf("package: finalizing\n");
+    cancel_prefetch();
     ASSERT(!n_users || CrawlIsCrashing); // not merely aborted, there are
         // live pointers to us. With normal stack unwinding, destructors
         // will make sure this never happens and this assert is good for
@@ -625,11 +656,194 @@ void package::abort()
 void package::unlink()
 {
     abort();
+    cancel_prefetch();
     close(fd);
     fd = -1;
     ::unlink_u(filename.c_str());
 }
 
+#ifdef PREFETCH_CHUNKS
+static bool _pread_all(int fd, void *buf, plen_t len, plen_t at)
+{
+    while (len)
+    {
+        ssize_t res = pread(fd, buf, len, at);
+        if (res <= 0)
+            return false;
+        buf = (char*)buf + res;
+        len -= res;
+        at += res;
+    }
+    return true;
+}
+
+// Like chunk_reader::read_all(), but failing quietly: the chunk is read
+// again the usual way if anything is amiss.
+static void *_prefetch_chunk(void *arg)
+{
+    chunk_prefetch *pf = static_cast<chunk_prefetch *>(arg);
+
+    z_stream zs;
+    zs.zalloc    = 0;
+    zs.zfree     = 0;
+    zs.opaque    = Z_NULL;
+    zs.next_in   = Z_NULL;
+    zs.avail_in  = 0;
+    if (inflateInit(&zs) != Z_OK)
+        return nullptr;
+
+    Bytef z_buffer[32768];
+    size_t size = 0;
+    int res = Z_OK;
+    plen_t next_block = pf->start;
+    while (next_block && res == Z_OK && !pf->cancelled)
+    {
+        block_header bl;
+        if (next_block + sizeof(block_header) > pf->file_len
+            || !_pread_all(pf->fd, &bl, sizeof(block_header), next_block))
+        {
+            break;
+        }
+        plen_t off = next_block + sizeof(block_header);
+        plen_t block_left = htole(bl.len);
+        next_block = htole(bl.next);
+        if (!block_left || block_left > pf->file_len - off)
+            break;
+
+        while (block_left && res == Z_OK)
+        {
+            const plen_t s = min<plen_t>(block_left, sizeof(z_buffer));
+            if (!_pread_all(pf->fd, z_buffer, s, off))
+            {
+                res = Z_ERRNO;
+                break;
+            }
+            off += s;
+            block_left -= s;
+
+            zs.next_in  = z_buffer;
+            zs.avail_in = s;
+            do
+            {
+                if (pf->len == size)
+                {
+                    size = size ? size * 2 : 65536;
+                    void *grown = realloc(pf->data, size);
+                    if (!grown)
+                    {
+                        res = Z_MEM_ERROR;
+                        break;
+                    }
+                    pf->data = static_cast<unsigned char *>(grown);
+                }
+                zs.next_out  = pf->data + pf->len;
+                zs.avail_out = size - pf->len;
+                res = inflate(&zs, Z_NO_FLUSH);
+                pf->len = zs.next_out - pf->data;
+            } while (res == Z_OK && (zs.avail_in || !zs.avail_out));
+            // Merely out of input, until the next read.
+            if (res == Z_BUF_ERROR)
+                res = Z_OK;
+        }
+    }
+
+    pf->ok = res == Z_STREAM_END && !pf->cancelled;
+    inflateEnd(&zs);
+    return nullptr;
+}
+#endif
+
+/**
+ * Start reading and inflating a chunk on another thread, so that a reader
+ * opened on it soon after has only to copy it. The chunk's blocks are kept
+ * from reuse until then, as if a reader were open; a chunk written in the
+ * meantime is read afresh. Only one chunk is read ahead at a time.
+ *
+ * @param name The chunk to read.
+ */
+void package::prefetch(const string &name)
+{
+#ifdef PREFETCH_CHUNKS
+    if (prefetching && prefetching->name == name)
+        return;
+    cancel_prefetch();
+
+    plen_t *start = map_find(directory, name);
+    if (aborted || fd == -1 || !start)
+        return;
+
+    dprintf("prefetching chunk(%s)\n", name.c_str());
+    prefetching = new chunk_prefetch;
+    prefetching->name = name;
+    prefetching->start = *start;
+    prefetching->fd = fd;
+    prefetching->file_len = file_len;
+    prefetching->cancelled = false;
+    prefetching->data = nullptr;
+    prefetching->len = 0;
+    prefetching->ok = false;
+    reader_count[*start]++;
+
+    if (thread_create_joinable(&prefetching->thread, _prefetch_chunk,
+                               prefetching))
+    {
+        end_prefetch();
+    }
+#else
+    UNUSED(name);
+#endif
+}
+
+/**
+ * Collect a chunk read ahead by prefetch(), waiting for it if need be.
+ *
+ * @param name The chunk wanted.
+ * @param[out] data The chunk's contents, if it was read ahead.
+ * @return Whether the chunk was read ahead, and is still current.
+ */
+bool package::take_prefetched(const string &name, vector<unsigned char> &data)
+{
+    if (!prefetching || prefetching->name != name)
+        return false;
+
+#ifdef PREFETCH_CHUNKS
+    thread_join(prefetching->thread);
+#endif
+    plen_t *start = map_find(directory, name);
+    const bool ok = prefetching->ok && !aborted
+                    && start && *start == prefetching->start;
+    if (ok)
+        data.assign(prefetching->data, prefetching->data + prefetching->len);
+    dprintf("prefetched chunk(%s): %s\n", name.c_str(), ok ? "used" : "stale");
+    end_prefetch();
+    return ok;
+}
+
+/// Stop reading ahead, and forget what was read.
+void package::cancel_prefetch()
+{
+    if (!prefetching)
+        return;
+
+    prefetching->cancelled = true;
+#ifdef PREFETCH_CHUNKS
+    thread_join(prefetching->thread);
+#endif
+    end_prefetch();
+}
+
+void package::end_prefetch()
+{
+    const plen_t start = prefetching->start;
+    ASSERT(reader_count[start] > 0);
+    if (!--reader_count[start])
+        reader_count.erase(start);
+
+    free(prefetching->data);
+    delete prefetching;
+    prefetching = nullptr;
+}
+
 // the amount of free space not at the end of file
 plen_t package::get_slack()
 {
@@ -25,6 +25,7 @@ using std::vector;
 typedef uint32_t plen_t;
 
 class package;
+struct chunk_prefetch;
 
 class chunk_writer
 {
@@ -84,6 +85,11 @@ public:
     void abort();
     void unlink();
 
+    // reading a chunk ahead of its use, on another thread
+    void prefetch(const string &name);
+    bool take_prefetched(const string &name, vector<unsigned char> &data);
+    void cancel_prefetch();
+
     // statistics
     plen_t get_slack();
     plen_t get_size() const { return file_len; };
@@ -106,6 +112,7 @@ private:
     map<plen_t, pair<plen_t, plen_t> > block_map;
     set<plen_t> new_chunks;
     map<plen_t, uint32_t> reader_count;
+    chunk_prefetch *prefetching;
     plen_t extend_block(plen_t at, plen_t size, plen_t by);
     plen_t alloc_block(plen_t &size);
     void finish_chunk(const string &name, plen_t at);
@@ -120,6 +127,7 @@ private:
     void trace_chunk(plen_t start);
     void load();
     void load_traces();
+    void end_prefetch();
     friend class chunk_writer;
     friend class chunk_reader;
 };
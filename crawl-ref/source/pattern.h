@@ -116,6 +116,8 @@ public:
         return pattern;
     }
 
+    bool ignores_case() const { return ignore_case; }
+
 private:
     string pattern;
     mutable void *compiled_pattern;
@@ -150,6 +152,8 @@ public:
         return pattern;
     }
 
+    bool ignores_case() const { return ignore_case; }
+
 private:
     string pattern;
     bool ignore_case;
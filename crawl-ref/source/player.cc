@@ -43,6 +43,7 @@
 #include "hints.h"
 #include "hiscores.h"
 #include "invent.h"
+#include "item-name.h"
 #include "item-prop.h"
 #include "items.h"
 #include "item-use.h"
@@ -5033,6 +5034,7 @@ player::player()
     dactions.clear();
     level_stack.clear();
     type_ids.init(false);
+    item_type_knowledge_changed();
 
     banished_by.clear();
     banished_power = 0;
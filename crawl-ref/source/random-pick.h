@@ -5,8 +5,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "random.h"
 
+using std::map;
+using std::pair;
+using std::vector;
+
 enum distrib_type
 {
     FLAT, // full chance throughout the range
@@ -27,16 +36,33 @@ struct random_pick_entry
     T value;
 };
 
+// The valid entries of a weight list at one level, with their running
+// rarity totals, as consulted by random_picker::pick_cached().
+template <typename T>
+struct random_pick_table
+{
+    vector<T> values;
+    vector<int> cumulative;
+};
+
 template <typename T, int max>
 class random_picker
 {
 public:
     virtual ~random_picker();
     T pick(const random_pick_entry<T> *weights, int level, T none);
+    T pick_cached(const random_pick_entry<T> *weights, int level, T none);
     int probability_at(T entry, const random_pick_entry<T> *weights, int level);
     int rarity_at(const random_pick_entry<T> *pop,
                   int depth);
     virtual bool veto(T) { return false; }
+    // Whether veto() might reject anything at the moment. Subclasses that
+    // override veto() must override this too.
+    virtual bool can_veto() const { return false; }
+
+private:
+    const random_pick_table<T> &_cached_table(
+        const random_pick_entry<T> *weights, int level);
 };
 
 template <typename T, int max>
@@ -81,6 +107,64 @@ T random_picker<T, max>::pick(const random_pick_entry<T> *weights, int level,
     die("random_pick roll out of range");
 }
 
+/**
+ * Pick an entry like pick(), but from a table of cumulative rarities that is
+ * built once per (weights, level) pair and then reused.
+ *
+ * Makes the same single random2() roll as pick() and returns the same entry
+ * for it, so the two can be used interchangeably without changing seeded
+ * games. Only valid when can_veto() is false, and when weights points to a
+ * list with static storage duration (the cache is keyed on its address).
+ */
+template <typename T, int max>
+T random_picker<T, max>::pick_cached(const random_pick_entry<T> *weights,
+                                     int level, T none)
+{
+    ASSERT(!can_veto());
+
+    const random_pick_table<T> &table = _cached_table(weights, level);
+    if (table.values.empty())
+        return none;
+
+    const int roll = random2(table.cumulative.back()); // the roll!
+
+    // The first entry whose running total exceeds the roll is the one that
+    // pick()'s linear scan would stop at.
+    const auto it = std::upper_bound(table.cumulative.begin(),
+                                     table.cumulative.end(), roll);
+    ASSERT(it != table.cumulative.end());
+    return table.values[it - table.cumulative.begin()];
+}
+
+template <typename T, int max>
+const random_pick_table<T> &random_picker<T, max>::_cached_table(
+    const random_pick_entry<T> *weights, int level)
+{
+    static map<pair<const random_pick_entry<T> *, int>,
+               random_pick_table<T>> tables;
+
+    const auto key = std::make_pair(weights, level);
+    auto found = tables.find(key);
+    if (found != tables.end())
+        return found->second;
+
+    random_pick_table<T> &table = tables[key];
+    int totalrar = 0;
+    for (const random_pick_entry<T> *pop = weights; pop->rarity; pop++)
+    {
+        if (level < pop->minr || level > pop->maxr)
+            continue;
+
+        int rar = rarity_at(pop, level);
+        ASSERTM(rar > 0, "Rarity %d: %d at level %d", rar, pop->value, level);
+
+        totalrar += rar;
+        table.values.push_back(pop->value);
+        table.cumulative.push_back(totalrar);
+    }
+    return table;
+}
+
 template <typename T, int max>
 int random_picker<T, max>::probability_at(T entry,
                     const random_pick_entry<T> *weights, int level)
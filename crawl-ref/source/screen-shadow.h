@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @brief What the console view was last drawn with, cell by cell.
+**/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+/**
+ * What puttext() last drew in each cell of the console, so that it can leave
+ * the cells that still look the same alone. Anything else that draws over a
+ * cell must forget() it.
+ */
+class screen_shadow
+{
+public:
+    screen_shadow() : height(0), width(0) { }
+
+    /// Start over with a screen of this size, knowing no cells.
+    void resize(int h, int w)
+    {
+        height = std::max(h, 0);
+        width = std::max(w, 0);
+        cells.assign(height * width, shadow_cell());
+    }
+
+    bool has_size(int h, int w) const
+    {
+        return height == h && width == w;
+    }
+
+    /**
+     * Note that a glyph is wanted at (y, x), with 0-based coordinates.
+     *
+     * @return Whether the cell has to be drawn, since it doesn't already
+     *         show that glyph with those attributes.
+     */
+    bool draw(int y, int x, char32_t glyph, unsigned long attr, short pair)
+    {
+        if (y < 0 || y >= height || x < 0 || x >= width)
+            return true;
+
+        shadow_cell &cell = cells[y * width + x];
+        if (cell.known && cell.glyph == glyph && cell.attr == attr
+            && cell.pair == pair)
+        {
+            return false;
+        }
+        cell.known = true;
+        cell.glyph = glyph;
+        cell.attr = attr;
+        cell.pair = pair;
+        return true;
+    }
+
+    /// Something other than puttext() drew cells x0 to x1 - 1 of row y.
+    void forget(int y, int x0, int x1)
+    {
+        if (y < 0 || y >= height)
+            return;
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, width);
+        for (int x = x0; x < x1; ++x)
+            cells[y * width + x].known = false;
+    }
+
+    void forget_all()
+    {
+        for (shadow_cell &cell : cells)
+            cell.known = false;
+    }
+
+private:
+    struct shadow_cell
+    {
+        shadow_cell() : known(false), glyph(0), attr(0), pair(0) { }
+
+        bool known;
+        char32_t glyph;
+        unsigned long attr;
+        short pair;
+    };
+
+    int height;
+    int width;
+    vector<shadow_cell> cells;
+};
@@ -0,0 +1,112 @@
+-- run the fight simulator without a game, appending its results to fsim.csv
+
+-- This requires a build with wizard mode, as well as fake_pty, which may need
+-- to be built manually. It also needs a pty-based system, i.e. linux or mac.
+--   make debug    OR (this will be a lot faster):    make profile
+--   make util/fake_pty
+--
+-- examples.
+-- a minotaur berserker's attacks against an ogre as weapon skill goes up:
+--   util/fake_pty ./crawl -script fsim.lua -char MiBe -mons ogre
+--
+-- compare two axes against a stone giant over 8 processes, stopping each skill
+-- level once the average damage is known to within 2%:
+--   util/fake_pty ./crawl -script fsim.lua -char MiFi -mons "stone giant" \
+--       -kit "broad axe" "war axe" -jobs 8 -precision 2
+
+basic_usage = [[
+Usage: fsim.lua -char <combo> -mons <monster> [<args>]
+    -char <combo>:       species and background abbreviations, e.g. MiFi.
+    -mons <monster>:     the monster to fight.
+    -weapon <weapon>:    the starting weapon, for backgrounds that choose one.
+                         Defaults to unarmed.
+    -xl <n>:             the starting experience level. Defaults to 1.
+    -kit <kit> ...:      equipment to run the simulation with, in the format
+                         of the fsim_kit option; each kit is run in turn.
+    -mode <mode>:        attack or defense. Defaults to attack.
+    -scale <skill> ...:  the skills to scale, as for fsim_scale.
+    -double:             use the double scale (fighting and weapon skill, or
+                         armour and dodging) rather than the simple one.
+    -rounds <n>:         as for fsim_rounds.
+    -precision <n>:      as for fsim_precision.
+    -jobs <n>:           as for fsim_jobs.]]
+
+function parse_args(args, err_fun)
+    accum_init = { }
+    accum_params = { }
+    cur = nil
+    for _,a in ipairs(args) do
+        if string.find(a, '-') == 1 then
+            cur = a
+            if accum_params[a] ~= nil then err_fun("Repeated argument '" .. a .."'") end
+            accum_params[a] = { }
+        else
+            if cur == nil then
+                accum_init[#accum_init + 1] = a
+            else
+                accum_params[cur][#accum_params[cur] + 1] = a
+            end
+        end
+    end
+    return accum_init, accum_params
+end
+
+function one_arg(args, a)
+    if args[a] == nil or #(args[a]) ~= 1 then return nil end
+    return args[a][1]
+end
+
+function usage_error(extra)
+    local err = basic_usage
+    if extra ~= nil then
+        err = err .. "\n" .. extra
+    end
+    script.usage(err)
+end
+
+local arg_list = crawl.script_args()
+local args_init, args = parse_args(arg_list, usage_error)
+
+if #arg_list == 0 or #args_init ~= 0 then usage_error() end
+
+local combo = one_arg(args, "-char")
+if combo == nil or #combo ~= 4 then usage_error("\nNo valid -char supplied!") end
+local mons = one_arg(args, "-mons")
+if mons == nil then usage_error("\nNo -mons supplied!") end
+
+local function number_arg(a)
+    if args[a] == nil then return nil end
+    local n = tonumber(one_arg(args, a))
+    if n == nil then usage_error("\nInvalid argument to " .. a) end
+    return n
+end
+
+local xl = number_arg("-xl")
+local rounds = number_arg("-rounds")
+local precision = number_arg("-precision")
+local jobs = number_arg("-jobs")
+
+crawl.setopt("fsim_csv = true")
+crawl.setopt("fsim_mons = " .. mons)
+crawl.setopt("fsim_mode = " .. (one_arg(args, "-mode") or "attack"))
+if args["-scale"] ~= nil then
+    crawl.setopt("fsim_scale = " .. table.concat(args["-scale"], ", "))
+end
+if args["-kit"] ~= nil then
+    crawl.setopt("fsim_kit = " .. table.concat(args["-kit"], ", "))
+end
+if rounds ~= nil then crawl.setopt("fsim_rounds = " .. rounds) end
+if precision ~= nil then crawl.setopt("fsim_precision = " .. precision) end
+if jobs ~= nil then crawl.setopt("fsim_jobs = " .. jobs) end
+
+you.init(combo, one_arg(args, "-weapon") or "unarmed")
+if xl ~= nil then you.set_xl(xl) end
+
+debug.flush_map_memory()
+debug.goto_place("D:1")
+debug.generate_level()
+dgn.grid(2, 2, "floor")
+dgn.grid(2, 3, "floor")
+you.moveto(2, 2)
+
+wiz.fight_sim(args["-double"] ~= nil)
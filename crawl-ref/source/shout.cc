@@ -14,6 +14,7 @@
 #include "artefact.h"
 #include "branch.h"
 #include "database.h"
+#include "dbg-prof.h"
 #include "directn.h"
 #include "english.h"
 #include "env.h"
@@ -33,10 +34,16 @@
 #include "state.h"
 #include "stringutil.h"
 #include "terrain.h"
+#include "unwind.h"
 #include "view.h"
 #include "viewchar.h"
 
-static noise_grid _noise_grid;
+// Noises are registered on one grid while the other propagates, so that
+// monsters woken by a noise can make noises of their own.
+static noise_grid _noise_grids[2];
+static noise_grid *_noise_grid = &_noise_grids[0];
+static bool _propagating_noise = false;
+
 static void _actor_apply_noise(actor *act,
                                const coord_def &apparent_source,
                                int noise_intensity_millis);
@@ -762,17 +769,20 @@ void yell(const actor* mon)
 
 void apply_noises()
 {
-    // [ds] This copying isn't awesome, but we cannot otherwise handle
-    // the case where one set of noises wakes up monsters who then let
-    // out yips of their own, modifying _noise_grid while it is in the
-    // middle of propagate_noise().
-    if (_noise_grid.dirty())
-    {
-        noise_grid copy = _noise_grid;
-        // Reset the main grid.
-        _noise_grid.reset();
-        copy.propagate_noise();
-    }
+    // One set of noises can wake up monsters who then let out yips of
+    // their own. Those go on the other grid, and wait for the next call.
+    if (!_noise_grid->dirty() || _propagating_noise)
+        return;
+
+    prof_timer timer(PROF_NOISES);
+
+    noise_grid &propagating = *_noise_grid;
+    _noise_grid = &_noise_grids[_noise_grid == &_noise_grids[0]];
+    ASSERT(!_noise_grid->dirty());
+
+    unwind_bool propagating_flag(_propagating_noise, true);
+    propagating.propagate_noise();
+    propagating.reset();
 }
 
 // noisy() has a messaging service for giving messages to the player
@@ -813,7 +823,7 @@ bool noisy(int original_loudness, const coord_def& where,
     // Add +1 to scaled_loudness so that all squares adjacent to a
     // sound of loudness 1 will hear the sound.
     const string noise_msg(msg? msg : "");
-    _noise_grid.register_noise(
+    _noise_grid->register_noise(
         noise_t(where, noise_msg, (scaled_loudness + 1) * multiplier, who));
 
     // Some users of noisy() want an immediate answer to whether the
@@ -910,17 +920,40 @@ int noise_cell::turn_angle(const coord_def &next_delta) const
 }
 
 noise_grid::noise_grid()
-    : cells(), noises(), affected_actor_count(0)
+    : cells(), noises(), touched(), affected_actor_count(0)
 {
 }
 
 void noise_grid::reset()
 {
-    cells.init(noise_cell());
+    // Only the cells that noise reached need clearing.
+    for (const coord_def &p : touched)
+        cells(p) = noise_cell();
+    touched.clear();
     noises.clear();
     affected_actor_count = 0;
 }
 
+// Apply noise to a cell, remembering it for reset() if it was quiet.
+bool noise_grid::apply_noise_at(const coord_def &pos,
+                                int noise_intensity_millis,
+                                int noise_id,
+                                int travel_distance,
+                                const coord_def &neighbour_delta)
+{
+    noise_cell &cell(cells(pos));
+    const bool was_quiet = cell.noise_id == -1;
+    if (!cell.apply_noise(noise_intensity_millis, noise_id, travel_distance,
+                          neighbour_delta))
+    {
+        return false;
+    }
+
+    if (was_quiet)
+        touched.push_back(pos);
+    return true;
+}
+
 void noise_grid::register_noise(const noise_t &noise)
 {
     noise_cell &target_cell(cells(noise.noise_source));
@@ -929,10 +962,8 @@ void noise_grid::register_noise(const noise_t &noise)
         const int noise_index = noises.size();
         noises.push_back(noise);
         noises[noise_index].noise_id = noise_index;
-        cells(noise.noise_source).apply_noise(noise.noise_intensity_millis,
-                                              noise_index,
-                                              0,
-                                              coord_def(0, 0));
+        apply_noise_at(noise.noise_source, noise.noise_intensity_millis,
+                       noise_index, 0, coord_def(0, 0));
     }
 }
 
@@ -945,7 +976,10 @@ void noise_grid::propagate_noise()
     dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
          (unsigned int)noises.size());
 #endif
-    vector<coord_def> noise_perimeter[2];
+    // Cells are visited in buckets of equal travel distance from the
+    // nearest source. The buckets keep their storage between calls.
+    for (vector<coord_def> &bucket : noise_perimeter)
+        bucket.clear();
     int circ_index = 0;
 
     for (const noise_t &noise : noises)
@@ -1037,10 +1071,9 @@ bool noise_grid::propagate_noise_to_neighbour(int base_attenuation,
     if (noise_is_audible(attenuated_noise_intensity))
     {
         const int neighbour_old_distance = neighbour.noise_travel_distance;
-        if (neighbour.apply_noise(attenuated_noise_intensity,
-                                  cell.noise_id,
-                                  travel_distance,
-                                  next_pos - current_pos))
+        if (apply_noise_at(next_pos, attenuated_noise_intensity,
+                           cell.noise_id, travel_distance,
+                           next_pos - current_pos))
             // Return true only if we hadn't already registered this
             // cell as a neighbour (presumably with a lower volume).
             return neighbour_old_distance != travel_distance;
@@ -19,6 +19,7 @@
 #include "colour.h"
 #include "coordit.h"
 #include "database.h"
+#include "dbg-trace.h"
 #include "describe.h"
 #include "directn.h"
 #include "english.h"
@@ -1657,6 +1658,13 @@ spret your_spells(spell_type spell, int powc, bool allow_fail,
     ASSERT(!crawl_state.game_is_arena());
     ASSERT(!evoked_item || evoked_item->base_type == OBJ_WANDS);
 
+    trace_span span("spell", "player spell");
+    if (span.active())
+    {
+        span.set_label(spell_title(spell));
+        span.set_detail("player");
+    }
+
     const bool wiz_cast = (crawl_state.prev_cmd == CMD_WIZARD && !allow_fail);
 
     dist target_local;
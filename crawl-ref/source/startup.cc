@@ -169,6 +169,12 @@ static void _initialize()
     }
 #endif
 
+    if (SysEnv.arena_jobs)
+    {
+        release_cli_signals();
+        run_arena_batch(Options.game.arena_teams);
+    }
+
     if (!crawl_state.test_list)
     {
         if (!crawl_state.io_inited)
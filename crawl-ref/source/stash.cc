@@ -18,6 +18,7 @@
 #include "command.h"
 #include "coordit.h"
 #include "corpse.h"
+#include "dbg-alloc.h"
 #include "describe.h"
 #include "describe-spells.h"
 #include "directn.h"
@@ -27,6 +28,7 @@
 #include "god-passive.h"
 #include "hints.h"
 #include "invent.h"
+#include "item-name.h"
 #include "item-prop.h"
 #include "item-status-flag-type.h"
 #include "items.h"
@@ -34,7 +36,10 @@
 #include "menu.h"
 #include "message.h"
 #include "notes.h"
+#include "options.h"
 #include "output.h"
+#include "pattern.h"
+#include "player.h"
 #include "religion.h"
 #include "spl-book.h"
 #include "state.h"
@@ -235,6 +240,8 @@ bool Stash::unmark_trapping_nets()
     for (auto &item : items)
         if (item_is_stationary_net(item))
             item.net_placed = false, changed = true;
+    if (changed)
+        items_changed();
     return changed;
 }
 
@@ -262,6 +269,7 @@ void Stash::update()
 
     // Zap existing items
     items.clear();
+    items_changed();
 
     if (!_grid_has_perceived_item(pos))
     {
@@ -364,6 +372,66 @@ string Stash::feature_description() const
     return feat_desc;
 }
 
+static void _add_trigrams(stash_trigrams &trigrams, const string &s)
+{
+    for (size_t i = 2; i < s.size(); ++i)
+    {
+        const uint32_t tri = static_cast<uint8_t>(s[i - 2]) << 16
+                             | static_cast<uint8_t>(s[i - 1]) << 8
+                             | static_cast<uint8_t>(s[i]);
+        // Fibonacci hashing; the top nine bits pick one of 512.
+        trigrams.set(static_cast<uint32_t>(tri * 2654435761U) >> 23);
+    }
+}
+
+/**
+ * The text each of this stash's items is searched by, rebuilt only when
+ * something it depends on has changed.
+ *
+ * @param prefix The level name searches put in front of each item.
+ */
+const vector<stash_search_text> &Stash::search_text(const string &prefix) const
+{
+    // {autopickup} annotations follow the player, not just the item.
+    const int turn = Options.autopickup_search ? you.num_turns : -1;
+    if (search_text_valid
+        && search_cache_prefix == prefix
+        && search_cache_epoch == identification_epoch()
+        && search_cache_generation == Options.autopickup_generation
+        && search_cache_turn == turn)
+    {
+        return search_cache;
+    }
+
+    search_cache.clear();
+    search_cache_trigrams.reset();
+    for (const item_def &item : items)
+    {
+        stash_search_text st;
+        st.name = stash_item_name(item);
+        st.text = prefix + " "
+                  + stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item)
+                  + " " + st.name;
+        st.lower_text = lowercase_string(st.text);
+        st.dumpable = is_dumpable_artefact(item);
+        if (st.dumpable)
+        {
+            st.desc = chardump_desc(item);
+            st.lower_desc = lowercase_string(st.desc);
+        }
+        _add_trigrams(search_cache_trigrams, st.lower_text);
+        _add_trigrams(search_cache_trigrams, st.lower_desc);
+        search_cache.push_back(move(st));
+    }
+
+    search_cache_prefix = prefix;
+    search_cache_epoch = identification_epoch();
+    search_cache_generation = Options.autopickup_generation;
+    search_cache_turn = turn;
+    search_text_valid = true;
+    return search_cache;
+}
+
 vector<stash_search_result> Stash::matches_search(
     const string &prefix, const base_pattern &search) const
 {
@@ -371,18 +439,34 @@ vector<stash_search_result> Stash::matches_search(
     if (empty())
         return results;
 
-    for (const item_def &item : items)
-    {
-        const string s   = stash_item_name(item);
-        const string ann = stash_annotate_item(STASH_LUA_SEARCH_ANNOTATE, &item);
-        if (search.matches(prefix + " " + ann + " " + s)
-            || is_dumpable_artefact(item) && search.matches(chardump_desc(item)))
+    // Plain searches (the default) are a lowercased substring test, so they
+    // can skip any stash missing one of the search's three-letter pieces.
+    const plaintext_pattern *plain
+        = dynamic_cast<const plaintext_pattern *>(&search);
+    if (plain && !plain->ignores_case())
+        plain = nullptr;
+    const string needle = plain ? lowercase_string(plain->tostring()) : "";
+
+    const vector<stash_search_text> &texts = search_text(prefix);
+    stash_trigrams wanted;
+    _add_trigrams(wanted, needle);
+    const bool may_match = (wanted & ~search_cache_trigrams).none();
+
+    for (size_t i = 0; may_match && i < items.size(); ++i)
+    {
+        const stash_search_text &st = texts[i];
+        const bool found = plain
+            ? st.lower_text.find(needle) != string::npos
+              || st.dumpable && st.lower_desc.find(needle) != string::npos
+            : search.matches(st.text)
+              || st.dumpable && search.matches(st.desc);
+        if (found)
         {
             stash_search_result res;
             res.match_type = MATCH_ITEM;
-            res.match = s;
-            res.primary_sort = item.name(DESC_QUALNAME);
-            res.item = item;
+            res.match = st.name;
+            res.primary_sort = items[i].name(DESC_QUALNAME);
+            res.item = items[i];
             results.push_back(res);
         }
     }
@@ -419,6 +503,7 @@ void Stash::_update_corpses(int rot_time)
 
         int new_rot = static_cast<int>(item.stash_freshness) - rot_time;
 
+        items_changed();
         if (new_rot <= _min_rot(item))
         {
             items.erase(items.begin() + i);
@@ -432,8 +517,11 @@ void Stash::_update_identification()
 {
     for (int i = items.size() - 1; i >= 0; i--)
     {
+        const iflags_t old_flags = items[i].flags;
         god_id_item(items[i]);
         maybe_identify_base_type(items[i]);
+        if (items[i].flags != old_flags)
+            items_changed();
     }
 }
 
@@ -446,6 +534,7 @@ void Stash::add_item(const item_def &item, bool add_to_front)
         items.insert(items.begin(), item);
     else
         items.push_back(item);
+    items_changed();
 
     seen_item(item);
 
@@ -550,6 +639,7 @@ void Stash::load(reader& inf)
 
     // Zap out item vector, in case it's in use (however unlikely)
     items.clear();
+    items_changed();
     // Read in the items
     for (int i = 0; i < count; ++i)
     {
@@ -745,6 +835,7 @@ ShopInfo &LevelStashes::get_shop(const coord_def& c)
 // otherwise.
 bool LevelStashes::update_stash(const coord_def& c)
 {
+    alloc_scope scope(ALLOC_STASHES);
     Stash *s = find_stash(c);
     if (!s)
         return false;
@@ -785,6 +876,7 @@ void LevelStashes::kill_stash(const Stash &s)
 
 void LevelStashes::add_stash(coord_def p)
 {
+    alloc_scope scope(ALLOC_STASHES);
     Stash *s = find_stash(p);
     if (s)
     {
@@ -962,6 +1054,7 @@ void LevelStashes::remove_shop(const coord_def& c)
 
 LevelStashes &StashTracker::get_current_level()
 {
+    alloc_scope scope(ALLOC_STASHES);
     return levels[level_id::current()];
 }
 
@@ -1053,6 +1146,7 @@ void StashTracker::save(writer& outf) const
 
 void StashTracker::load(reader& inf)
 {
+    alloc_scope scope(ALLOC_STASHES);
     // Time of last corpse update.
     last_corpse_update = unmarshallInt(inf);
 
@@ -1070,6 +1164,7 @@ void StashTracker::load(reader& inf)
 
 void StashTracker::update_visible_stashes()
 {
+    alloc_scope scope(ALLOC_STASHES);
     LevelStashes *lev = find_current_level();
     for (radius_iterator ri(you.pos(),
                             you.xray_vision ? LOS_NONE : LOS_DEFAULT); ri; ++ri)
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <bitset>
 #include <map>
 #include <string>
 #include <vector>
@@ -18,6 +19,23 @@ class writer;
 class StashMenu;
 
 struct stash_search_result;
+
+/// What stash searches match one stashed item against.
+struct stash_search_text
+{
+    string name;        ///< Stash::stash_item_name()
+    string text;        ///< level, annotations and name
+    string lower_text;  ///< text, lowercased for plain searches
+    bool dumpable;      ///< whether desc is searched too
+    string desc;        ///< full description, for dumpable artefacts
+    string lower_desc;
+};
+
+// Bits in the summary of the three-letter sequences in a stash's search
+// text, used to skip whole stashes that cannot match a plain search.
+#define STASH_TRIGRAM_BITS 512 // _add_trigrams() assumes this
+typedef bitset<STASH_TRIGRAM_BITS> stash_trigrams;
+
 class Stash
 {
 public:
@@ -65,6 +83,8 @@ private:
     void _update_corpses(int rot_time);
     void _update_identification();
     void add_item(const item_def &item, bool add_to_front = false);
+    const vector<stash_search_text> &search_text(const string &prefix) const;
+    void items_changed() { search_text_valid = false; }
 
 private:
     bool visited;      // Is this correct to the best of our knowledge?
@@ -75,6 +95,17 @@ private:
 
     vector<item_def> items;
 
+    // Building the search text means naming every item and calling the Lua
+    // annotation hook, so it is kept until the items change, item types
+    // are identified, or the rc file (and so perhaps the hook) is reread.
+    mutable vector<stash_search_text> search_cache;
+    mutable stash_trigrams search_cache_trigrams;
+    mutable string search_cache_prefix;
+    mutable unsigned search_cache_epoch = 0;
+    mutable unsigned search_cache_generation = 0;
+    mutable int search_cache_turn = -1;
+    mutable bool search_text_valid = false;
+
     static bool are_items_same(const item_def &, const item_def &,
                                bool exact = false);
 
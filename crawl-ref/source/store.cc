@@ -10,6 +10,7 @@
 
 #include <algorithm>
 
+#include "dbg-alloc.h"
 #include "dlua.h"
 #include "monster.h"
 #include "stringutil.h"
@@ -297,6 +298,7 @@ void CrawlStoreValue::unset(bool force)
 
 CrawlStoreValue &CrawlStoreValue::operator = (const CrawlStoreValue &other)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT_RANGE(other.type, SV_NONE, NUM_STORE_VAL_TYPES);
     ASSERT(other.type != SV_NONE || type == SV_NONE);
 
@@ -547,6 +549,7 @@ void CrawlStoreValue::write(writer &th) const
 
 void CrawlStoreValue::read(reader &th)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT(type == SV_NONE);
 
     type = static_cast<store_val_type>(unmarshallByte(th));
@@ -761,6 +764,7 @@ CrawlVector &CrawlStoreValue::new_vector(store_val_type _type,
     return field;
 
 #define GET_VAL_PTR(x, _type, value) \
+    alloc_scope scope(ALLOC_PROPS); \
     ASSERT((flags & SFLAG_UNSET) || !(flags & SFLAG_CONST_VAL)); \
     if (type != (x) || (flags & SFLAG_UNSET)) \
     { \
@@ -1227,6 +1231,7 @@ void CrawlHashTable::write(writer &th) const
 
 void CrawlHashTable::read(reader &th)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT_VALIDITY();
 
     ASSERT(empty());
@@ -1335,6 +1340,7 @@ void CrawlHashTable::assert_validity() const
 
 CrawlStoreValue& CrawlHashTable::get_value(const string &key)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT_VALIDITY();
     ACCESS(key);
     // Inserts CrawlStoreValue() if the key was not found.
@@ -1411,6 +1417,7 @@ void CrawlVector::write(writer &th) const
 
 void CrawlVector::read(reader &th)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT_VALIDITY();
 
     ASSERT(empty());
@@ -1619,6 +1626,7 @@ void CrawlVector::pop_back()
 
 void CrawlVector::push_back(CrawlStoreValue val)
 {
+    alloc_scope scope(ALLOC_PROPS);
 #ifdef DEBUG
     if (type != SV_NONE)
         ASSERT(type == val.type);
@@ -1677,6 +1685,7 @@ void CrawlVector::push_back(CrawlStoreValue val)
 
 void CrawlVector::insert(const vec_size index, CrawlStoreValue val)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT_VALIDITY();
     ASSERT(vec.size() < max_size);
     ASSERT(type == SV_NONE
@@ -1693,6 +1702,7 @@ void CrawlVector::insert(const vec_size index, CrawlStoreValue val)
 
 void CrawlVector::resize(const vec_size _size)
 {
+    alloc_scope scope(ALLOC_PROPS);
     ASSERT_VALIDITY();
     ASSERT(max_size == VEC_MAX_SIZE);
     ASSERT(_size < max_size);
@@ -16,11 +16,13 @@
 # include <wincrypt.h>
 # include <io.h>
 #else
+# include <cerrno>
 # include <dirent.h>
 # include <unistd.h>
 # include <fcntl.h>
 # include <sys/types.h>
 # include <sys/stat.h>
+# include <sys/wait.h>
 #endif
 
 #include "files.h"
@@ -533,3 +535,97 @@ int open_u(const char *pathname, int flags, mode_t mode)
     return open(OUTS(pathname), flags, mode);
 #endif
 }
+
+#ifndef TARGET_OS_WINDOWS
+static bool _write_fully(int fd, const vector<unsigned char> &buf)
+{
+    size_t done = 0;
+    while (done < buf.size())
+    {
+        const ssize_t n = write(fd, &buf[done], buf.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
+
+static bool _read_fully(int fd, vector<unsigned char> &buf)
+{
+    unsigned char chunk[65536];
+    while (true)
+    {
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return false;
+        if (!n)
+            return true;
+        buf.insert(buf.end(), chunk, chunk + n);
+    }
+}
+
+/**
+ * Fork a worker process for each job, and collect what they produce.
+ *
+ * Each worker calls work(job) on its own copy of the game state, sends the
+ * bytes it returns back over a pipe, and leaves with _exit() so that none of
+ * our exit handlers run twice. All workers run at once.
+ *
+ * @returns one buffer per job, in job order. A buffer is empty if that
+ *          worker crashed, exited abnormally, or returned nothing.
+ */
+vector<vector<unsigned char>> run_forked_jobs(int jobs,
+        const function<vector<unsigned char>(int job)> &work)
+{
+    vector<pid_t> workers;
+    vector<int> pipes;
+    for (int job = 0; job < jobs; ++job)
+    {
+        int fds[2];
+        if (pipe(fds) == -1)
+            die("Couldn't create a pipe for a worker: %s", strerror(errno));
+
+        fflush(stdout);
+        fflush(stderr);
+        const pid_t pid = fork();
+        if (pid == -1)
+            die("Couldn't fork a worker: %s", strerror(errno));
+
+        if (!pid)
+        {
+            close(fds[0]);
+            for (int fd : pipes)
+                close(fd);
+
+            const bool sent = _write_fully(fds[1], work(job));
+            close(fds[1]);
+            fflush(stdout);
+            fflush(stderr);
+            _exit(sent ? 0 : 1);
+        }
+
+        close(fds[1]);
+        workers.push_back(pid);
+        pipes.push_back(fds[0]);
+    }
+
+    vector<vector<unsigned char>> results(jobs);
+    for (int job = 0; job < jobs; ++job)
+    {
+        const bool received = _read_fully(pipes[job], results[job]);
+        close(pipes[job]);
+
+        int status = 0;
+        while (waitpid(workers[job], &status, 0) == -1 && errno == EINTR)
+            ;
+
+        if (!received || !WIFEXITED(status) || WEXITSTATUS(status))
+            results[job].clear();
+    }
+    return results;
+}
+#endif
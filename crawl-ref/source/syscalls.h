@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include <functional>
 #include <sys/types.h>
+#include <vector>
 
 #include "config.h"
 
@@ -36,3 +38,8 @@ int unlink_u(const char *pathname);
 FILE *fopen_u(const char *path, const char *mode);
 int mkdir_u(const char *pathname, mode_t mode);
 int open_u(const char *pathname, int flags, mode_t mode);
+
+#ifndef TARGET_OS_WINDOWS
+vector<vector<unsigned char>> run_forked_jobs(int jobs,
+        const function<vector<unsigned char>(int job)> &work);
+#endif
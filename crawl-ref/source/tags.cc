@@ -121,7 +121,10 @@ reader::reader(package *save, const string &chunkname, int minorVersion)
      _minorVersion(minorVersion), _safe_read(false)
 {
     ASSERT(save);
-    _chunk = new chunk_reader(save, chunkname);
+    if (save->take_prefetched(chunkname, _prefetched))
+        _pbuf = &_prefetched;
+    else
+        _chunk = new chunk_reader(save, chunkname);
 }
 
 reader::~reader()
@@ -234,7 +237,7 @@ void reader::fail_if_not_eof(const string &name)
     char dummy;
     if (_chunk ? _chunk->read(&dummy, 1) :
         _file ? (fgetc(_file) != EOF) :
-        _read_offset >= _pbuf->size())
+        _read_offset < _pbuf->size())
     {
         fail("Incomplete read of \"%s\" - aborting.", name.c_str());
     }
@@ -4026,6 +4029,7 @@ static void _tag_read_you_items(reader &th)
         for (int j = count2; j < MAX_SUBTYPES; ++j)
             you.type_ids[i][j] = false;
     }
+    item_type_knowledge_changed();
 
 #if TAG_MAJOR_VERSION == 34
     if (th.getMinorVersion() < TAG_MINOR_ID_STATES)
@@ -4526,9 +4530,12 @@ static void _tag_construct_level(writer &th)
 
     // how many clouds?
     marshallShort(th, env.cloud.size());
-    for (const auto& entry : env.cloud)
+    // Write them in position order, as they were when stored in a map.
+    vector<coord_def> cloud_locs = env.cloud.cells();
+    sort(cloud_locs.begin(), cloud_locs.end());
+    for (const coord_def &pos : cloud_locs)
     {
-        const cloud_struct& cloud = entry.second;
+        const cloud_struct& cloud = *env.cloud.find(pos);
         marshallByte(th, cloud.type);
         ASSERT(cloud.type != CLOUD_NONE);
         ASSERT_IN_BOUNDS(cloud.pos);
@@ -6111,7 +6118,7 @@ static void _tag_read_level(reader &th)
         // 0.18-a0-629-g16988c9.
         if (!cell_is_solid(cloud.pos))
 #endif
-            env.cloud[cloud.pos] = cloud;
+            env.cloud.put(cloud.pos, cloud);
     }
 
     EAT_CANARY;
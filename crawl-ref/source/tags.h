@@ -143,6 +143,7 @@ private:
     chunk_reader *_chunk;
     bool  opened_file;
     const vector<unsigned char>* _pbuf;
+    vector<unsigned char> _prefetched;
     unsigned int _read_offset;
     int _minorVersion;
     // always throw an exception rather than dying when reading past EOF
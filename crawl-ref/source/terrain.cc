@@ -13,6 +13,7 @@
 
 #include "areas.h"
 #include "attack.h"
+#include "beam.h"
 #include "branch.h"
 #include "cloud.h"
 #include "coord.h"
@@ -1893,6 +1894,8 @@ const char* feat_type_name(dungeon_feature_type feat)
 
 void set_terrain_changed(const coord_def p)
 {
+    invalidate_tracer_cache();
+
     if (cell_is_solid(p))
         delete_cloud(p);
 
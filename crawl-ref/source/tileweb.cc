@@ -20,6 +20,8 @@
 #include "command.h"
 #include "coord.h"
 #include "database.h"
+#include "dbg-prof.h"
+#include "dbg-trace.h"
 #include "directn.h"
 #include "english.h"
 #include "env.h"
@@ -63,6 +65,7 @@
 #include "version.h"
 #include "viewgeom.h"
 #include "view.h"
+#include "web-backlog.h"
 
 //#define DEBUG_WEBSOCKETS
 
@@ -79,6 +82,8 @@ TilesFramework tiles;
 
 TilesFramework::TilesFramework() :
       m_controlled_from_web(false),
+      m_map_update_pending(false),
+      m_player_update_pending(false),
       _send_lock(false),
       m_last_ui_state(UI_INIT),
       m_view_loaded(false),
@@ -107,6 +112,25 @@ void TilesFramework::shutdown()
     if (m_sock_name.empty())
         return;
 
+    _send_frame();
+
+    // Give slow receivers a few seconds to take the last messages (such
+    // as the exit reason) before we go.
+    for (int tries = 0; tries < 500 && _has_queued_output(); ++tries)
+    {
+        for (unsigned int i = 0; i < m_receivers.size(); ++i)
+        {
+            if (!_send_queued(m_receivers[i]))
+            {
+                m_receivers.erase(m_receivers.begin() + i);
+                i--;
+            }
+            else if (m_receivers[i].queue.empty())
+                m_receivers[i].resync = false;
+        }
+        usleep(10 * 1000);
+    }
+
     close(m_sock);
     remove(m_sock_name.c_str());
 }
@@ -181,102 +205,232 @@ void TilesFramework::write_message(const char *format, ...)
     m_msg_buf.append(buf);
 }
 
-void TilesFramework::finish_message()
+// How far a receiver may fall behind before we stop queueing for it and
+// resend the whole game state once it catches up instead.
+static const size_t MAX_QUEUED_BYTES = 4 * 1024 * 1024;
+
+// Send as much of msg, starting at offset sent, as the receiver will take
+// without blocking. Returns false if the receiver has gone away.
+bool TilesFramework::_send_fragments(const sockaddr_un &addr,
+                                     const string &msg, size_t &sent)
 {
-    if (m_msg_buf.size() == 0)
-        return;
+    while (sent < msg.size())
+    {
+        const size_t fragment_size = min(msg.size() - sent,
+                                         (size_t) m_max_msg_size);
+        ssize_t retval = sendto(m_sock, msg.data() + sent, fragment_size,
+                                MSG_DONTWAIT, (const sockaddr*) &addr,
+                                sizeof(sockaddr_un));
+        if (retval > 0)
+        {
+            sent += retval;
+            continue;
+        }
+
+        if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
+            || errno == EINTR || errno == EAGAIN)
+        {
+            // Their buffer is full; try again later.
+#ifdef DEBUG_WEBSOCKETS
+            fprintf(stderr, "websocket: receiver busy, %d bytes left.\n",
+                    (int) (msg.size() - sent));
+#endif
+            return true;
+        }
+        else if (errno == ECONNREFUSED || errno == ENOENT)
+        {
+            // the other side is dead
 #ifdef DEBUG_WEBSOCKETS
-    const int initial_buf_size = m_msg_buf.size();
-    fprintf(stderr, "websocket: About to send %d bytes.\n", initial_buf_size);
+            fprintf(stderr, "websocket: receiver gone (%s).\n",
+                    strerror(errno));
 #endif
+            return false;
+        }
+        else
+            die("Socket write error: %s", strerror(errno));
+    }
+    return true;
+}
 
-    if (m_sock_name.empty())
+// Send what we can of the receiver's backlog. Returns false if the receiver
+// has gone away.
+bool TilesFramework::_send_queued(Receiver &recv)
+{
+    while (!recv.queue.empty())
     {
-        m_msg_buf.clear();
+        const string &msg = recv.queue.front();
+        if (!_send_fragments(recv.addr, msg, recv.sent))
+            return false;
+        if (recv.sent < msg.size())
+            return true;
+
+        recv.queued_bytes -= msg.size();
+        recv.queue.pop_front();
+        recv.sent = 0;
+    }
+    return true;
+}
+
+void TilesFramework::_queue_message(Receiver &recv, const string &msg,
+                                    size_t sent)
+{
+    if (recv.queue.empty())
+        recv.sent = sent;
+    recv.queue.push_back(msg);
+    recv.queued_bytes += msg.size();
+
+    if (recv.queued_bytes <= MAX_QUEUED_BYTES)
         return;
+
+    // Too slow to keep up: drop the game state updates, and send everything
+    // afresh once the receiver has caught up.
+    const size_t kept_bytes = trim_web_backlog(recv.queue, recv.sent);
+#ifdef DEBUG_WEBSOCKETS
+    fprintf(stderr, "websocket: dropping %d queued bytes for a slow "
+                    "receiver.\n", (int) (recv.queued_bytes - kept_bytes));
+#endif
+    recv.queued_bytes = kept_bytes;
+    recv.resync = true;
+}
+
+bool TilesFramework::_has_queued_output() const
+{
+    for (const Receiver &recv : m_receivers)
+        if (!recv.queue.empty() || recv.resync)
+            return true;
+    return false;
+}
+
+// Push out queued messages, forget receivers that have gone away, and bring
+// any that fell behind back up to date.
+void TilesFramework::_service_receivers()
+{
+    bool resync = false;
+    for (unsigned int i = 0; i < m_receivers.size(); ++i)
+    {
+        Receiver &recv = m_receivers[i];
+        if (!_send_queued(recv))
+        {
+            m_receivers.erase(m_receivers.begin() + i);
+            i--;
+            continue;
+        }
+        if (recv.resync && recv.queue.empty())
+        {
+            recv.resync = false;
+            resync = true;
+        }
     }
 
-    m_msg_buf.append("\n");
-    const char* fragment_start = m_msg_buf.data();
-    const char* data_end = m_msg_buf.data() + m_msg_buf.size();
-    int fragments = 0;
-    while (fragment_start < data_end)
+    if (resync && !_send_lock)
     {
-        int fragment_size = data_end - fragment_start;
-        if (fragment_size > m_max_msg_size)
-            fragment_size = m_max_msg_size;
-        fragments++;
+        // Like a spectator joining; everyone else gets the update too.
+        flush_messages();
+        _send_everything();
+        flush_messages();
+    }
+}
+
+// Send a complete, newline-terminated message to every receiver.
+void TilesFramework::_send_to_receivers(const string &msg)
+{
+    trace_span span("webtiles", "send");
+    if (span.active())
+        span.set_detail(make_stringf("%u bytes", (unsigned int) msg.size()));
 
-        for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
-        {
-            int retries = 30;
-            ssize_t sent = 0;
-            while (sent < fragment_size)
-            {
-                ssize_t retval = sendto(m_sock, fragment_start + sent,
-                    fragment_size - sent, 0, (sockaddr*) &m_dest_addrs[i],
-                    sizeof(sockaddr_un));
 #ifdef DEBUG_WEBSOCKETS
-                fprintf(stderr,
-                            "    trying to send fragment to client %d...", i);
+    int queued = 0;
 #endif
-                if (retval <= 0)
-                {
-                    const char *errmsg = retval == 0 ? "No bytes sent"
-                                                     : strerror(errno);
-                    if (--retries <= 0)
-                        die("Socket write error: %s", errmsg);
+    for (unsigned int i = 0; i < m_receivers.size(); ++i)
+    {
+        Receiver &recv = m_receivers[i];
+        // Keep messages in order: anything already waiting goes first.
+        if (!_send_queued(recv))
+        {
+            m_receivers.erase(m_receivers.begin() + i);
+            i--;
+            continue;
+        }
 
-                    if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
-                        || errno == EINTR || errno == EAGAIN)
-                    {
-                        // Wait for half a second at first (up to five), then
-                        // try again.
-                        const int sleep_time = retries > 25 ? 2 * 1000
-                                             : retries > 10 ? 500 * 1000
-                                             : 5000 * 1000;
+        // One that fell behind gets the game state resent later anyway,
+        // but not everything can wait for that.
+        if (recv.resync && !web_message_must_arrive(msg))
+            continue;
+
+        size_t sent = 0;
+        if (recv.queue.empty() && !_send_fragments(recv.addr, msg, sent))
+        {
+            m_receivers.erase(m_receivers.begin() + i);
+            i--;
+            continue;
+        }
+
+        if (sent < msg.size())
+        {
+            _queue_message(recv, msg, sent);
 #ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr, "failed (%s), sleeping for %dms.\n",
-                                                    errmsg, sleep_time / 1000);
+            queued++;
 #endif
-                        usleep(sleep_time);
-                    }
-                    else if (errno == ECONNREFUSED || errno == ENOENT)
-                    {
-                        // the other side is dead
+        }
+    }
 #ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr,
-                            "failed (%s), breaking.\n", errmsg);
+    // should the game actually crash in this case?
+    if (m_controlled_from_web && m_receivers.size() == 0)
+        fprintf(stderr, "No open websockets after finish_message!!\n");
+
+    fprintf(stderr, "websocket: Sent %d bytes, queued for %d receivers.\n",
+                                                (int) msg.size(), queued);
 #endif
-                        m_dest_addrs.erase(m_dest_addrs.begin() + i);
-                        i--;
-                        break;
-                    }
-                    else
-                        die("Socket write error: %s", errmsg);
-                }
-                else
-                {
+}
+
+// The webserver passes game messages on to clients in batches when asked to
+// flush, wrapping them as {"msgs":[...]}; joining a frame's messages with
+// commas here therefore reaches clients unchanged.
+static const size_t MAX_FRAME_BYTES = 256 * 1024;
+
+void TilesFramework::_send_frame()
+{
+    if (m_frame_buf.empty())
+        return;
+
+    m_frame_buf.append("\n");
+    _send_to_receivers(m_frame_buf);
+    m_frame_buf.clear();
+}
+
+void TilesFramework::finish_message()
+{
+    if (m_msg_buf.size() == 0)
+        return;
 #ifdef DEBUG_WEBSOCKETS
-                    fprintf(stderr, "fragment size %d sent.\n", fragment_size);
+    fprintf(stderr, "websocket: Finished a message of %d bytes.\n",
+            (int) m_msg_buf.size());
 #endif
-                    sent += retval;
-                }
-            }
-        }
 
-        fragment_start += fragment_size;
+    if (m_sock_name.empty())
+    {
+        m_msg_buf.clear();
+        return;
+    }
+
+    if (m_msg_buf[0] == '*')
+    {
+        // Messages for the webserver itself are read one at a time, and
+        // must come after everything sent before them.
+        _send_frame();
+        m_msg_buf.append("\n");
+        _send_to_receivers(m_msg_buf);
+    }
+    else
+    {
+        if (!m_frame_buf.empty())
+            m_frame_buf.append(",");
+        m_frame_buf.append(m_msg_buf);
+        if (m_frame_buf.size() > MAX_FRAME_BYTES)
+            _send_frame();
     }
     m_msg_buf.clear();
     m_need_flush = true;
-#ifdef DEBUG_WEBSOCKETS
-    // should the game actually crash in this case?
-    if (m_controlled_from_web && m_dest_addrs.size() == 0)
-        fprintf(stderr, "No open websockets after finish_message!!\n");
-
-    fprintf(stderr, "websocket: Sent %d bytes in %d fragments.\n",
-                                                initial_buf_size, fragments);
-#endif
 }
 
 void TilesFramework::send_message(const char *format, ...)
@@ -301,12 +455,47 @@ void TilesFramework::send_message(const char *format, ...)
     finish_message();
 }
 
+/**
+ * Send the map and player updates that redraw() has held back. This ends
+ * the frame as far as the map is concerned; anything that must be seen
+ * after the map as it stands now (such as a delay) needs to call this first.
+ */
+void TilesFramework::flush_frame_updates()
+{
+    // The map can't be sent while some other message is being sent.
+    if (_send_lock)
+        return;
+
+    // Player first, otherwise HP/MP bars can be left behind in the old
+    // location if the player has moved.
+    if (m_player_update_pending)
+    {
+        m_player_update_pending = false;
+        _send_player();
+    }
+
+    if (m_map_update_pending)
+    {
+        m_map_update_pending = false;
+        if (m_current_flash_colour != m_next_flash_colour)
+        {
+            send_message("{\"msg\":\"flash\",\"col\":%d}",
+                         m_next_flash_colour);
+            m_current_flash_colour = m_next_flash_colour;
+        }
+        _send_map(false);
+    }
+}
+
 void TilesFramework::flush_messages()
 {
     if (_send_lock)
         return;
+    flush_frame_updates();
     unwind_bool no_rentry(_send_lock, true);
 
+    _send_frame();
+
     if (m_need_flush)
     {
         send_message("*{\"msg\":\"flush_messages\"}");
@@ -319,7 +508,7 @@ void TilesFramework::_await_connection()
     if (m_sock_name.empty())
         return;
 
-    while (m_dest_addrs.size() == 0)
+    while (m_receivers.size() == 0)
         _receive_control_message();
 }
 
@@ -373,7 +562,9 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
         JsonWrapper primary = json_find_member(obj.node, "primary");
         primary.check(JSON_BOOL);
 
-        m_dest_addrs.push_back(addr);
+        Receiver recv;
+        recv.addr = addr;
+        m_receivers.push_back(recv);
         m_controlled_from_web = primary->bool_;
     }
     else if (msgtype == "key")
@@ -489,7 +680,18 @@ bool TilesFramework::await_input(wint_t& c, bool block)
             if (block)
             {
                 tiles.flush_messages();
-                result = select(maxfd + 1, &fds, nullptr, nullptr, nullptr);
+                if (_has_queued_output())
+                {
+                    // Wake up now and then to feed slow receivers.
+                    timeval timeout;
+                    timeout.tv_sec = 0;
+                    timeout.tv_usec = 20 * 1000;
+
+                    result = select(maxfd + 1, &fds, nullptr, nullptr,
+                                    &timeout);
+                }
+                else
+                    result = select(maxfd + 1, &fds, nullptr, nullptr, nullptr);
             }
             else
             {
@@ -502,8 +704,15 @@ bool TilesFramework::await_input(wint_t& c, bool block)
         }
         while (result == -1 && errno == EINTR);
 
+        if (!m_sock_name.empty())
+            _service_receivers();
+
         if (result == 0)
+        {
+            if (block)
+                continue;
             return false;
+        }
         else if (result > 0)
         {
             if (!m_sock_name.empty() && FD_ISSET(m_sock, &fds))
@@ -1559,8 +1768,109 @@ void TilesFramework::_send_cell(const coord_def &gc,
     json_close_object(true);
 }
 
+// Monsters and dolls update other state as they are sent, so only cells
+// without them are snapshotted.
+static bool _can_snapshot_cell(const screen_cell_t &sc, const map_cell &mc)
+{
+    const tileidx_t fg_idx = sc.tile.fg & TILE_FLAG_MASK;
+    return !mc.monsterinfo() && fg_idx != TILEP_PLAYER
+           && fg_idx < TILEP_MCACHE_START;
+}
+
+// Does the tile data that _send_cell() writes for a full send match?
+static bool _same_tile_output(const packed_cell &a, const packed_cell &b)
+{
+    if (a.fg != b.fg || a.bg != b.bg || a.cloud != b.cloud
+        || a.is_bloody != b.is_bloody || a.old_blood != b.old_blood
+        || a.is_silenced != b.is_silenced || a.halo != b.halo
+        || a.is_highlighted_summoner != b.is_highlighted_summoner
+        || a.is_sanctuary != b.is_sanctuary
+        || a.is_liquefied != b.is_liquefied || a.orb_glow != b.orb_glow
+        || a.quad_glow != b.quad_glow || a.disjunct != b.disjunct
+        || a.mangrove_water != b.mangrove_water
+        || a.awakened_forest != b.awakened_forest
+        || a.blood_rotation != b.blood_rotation
+        || a.travel_trail != b.travel_trail
+        || a.flv.floor != b.flv.floor || a.flv.special != b.flv.special
+        || a.num_dngn_overlay != b.num_dngn_overlay)
+    {
+        return false;
+    }
+    for (int i = 0; i < a.num_dngn_overlay; ++i)
+        if (a.dngn_overlay[i] != b.dngn_overlay[i])
+            return false;
+    return true;
+}
+
+// Everything other than the tile data that a full send of this cell
+// depends on.
+void TilesFramework::_fill_snapshot_key(const coord_def &gc,
+                                        CellSnapshot &snap)
+{
+    const screen_cell_t &sc = m_next_view(gc);
+    const tileidx_t fg_idx = sc.tile.fg & TILE_FLAG_MASK;
+
+    snap.feat = env.map_knowledge(gc).feat();
+    snap.mf = get_cell_map_feature(gc);
+    snap.glyph = sc.glyph;
+    snap.col = sc.glyph == ' ' ? -1
+        : (_get_brand(sc.colour) << 4) | macro_colour(sc.colour & 0xF);
+    snap.base = sc.tile.fg && get_tile_texture(fg_idx) == TEX_DEFAULT
+        ? (int) tileidx_known_base_item(fg_idx) : -1;
+}
+
+// Write a cell for a full map send from its snapshot, if that is still
+// accurate.
+bool TilesFramework::_send_cell_snapshot(const coord_def &gc)
+{
+    const CellSnapshot &snap = m_cell_snapshots(gc);
+    if (!snap.valid
+        || !_can_snapshot_cell(m_next_view(gc), env.map_knowledge(gc))
+        || !_same_tile_output(snap.tile, m_next_view(gc).tile))
+    {
+        return false;
+    }
+
+    CellSnapshot key;
+    _fill_snapshot_key(gc, key);
+    if (key.feat != snap.feat || key.mf != snap.mf || key.glyph != snap.glyph
+        || key.col != snap.col || key.base != snap.base)
+    {
+        return false;
+    }
+
+    if (!snap.json.empty())
+    {
+        json_write_comma();
+        m_msg_buf.append(snap.json);
+    }
+    return true;
+}
+
+// Remember what a full send just wrote for a cell, from json_start on.
+void TilesFramework::_store_cell_snapshot(const coord_def &gc,
+                                          size_t json_start)
+{
+    CellSnapshot &snap = m_cell_snapshots(gc);
+    snap.valid = _can_snapshot_cell(m_next_view(gc), env.map_knowledge(gc));
+    if (!snap.valid)
+        return;
+
+    _fill_snapshot_key(gc, snap);
+    snap.tile = m_next_view(gc).tile;
+    snap.tile.map_knowledge.clear();
+    snap.json = m_msg_buf.substr(json_start);
+    // Stored without the separator from whatever preceded it.
+    if (!snap.json.empty() && snap.json[0] == ',')
+        snap.json.erase(0, 1);
+}
+
 void TilesFramework::_send_cursor(cursor_type type)
 {
+    // Cursor positions are relative to the map's origin, so the client
+    // needs to be up to date with the map first.
+    flush_frame_updates();
+
     if (m_cursor[type] == NO_CURSOR)
         send_message("{\"msg\":\"cursor\",\"id\":%d}", type);
     else
@@ -1603,6 +1913,8 @@ void TilesFramework::_send_map(bool force_full)
 
     unwind_bool no_rentry(_send_lock, true);
 
+    prof_timer timer(PROF_SEND_MAP);
+
     map<uint32_t, coord_def> new_monster_locs;
 
     force_full = force_full || m_need_full_map;
@@ -1677,11 +1989,17 @@ void TilesFramework::_send_map(bool force_full)
                 : m_current_view(gc);
             const map_cell& mc = force_full ? default_map_cell
                 : m_current_map_knowledge(gc);
-            _send_cell(gc,
-                       sc,
-                       m_next_view(gc),
-                       mc, env.map_knowledge(gc),
-                       new_monster_locs, force_full);
+            if (!force_full || !_send_cell_snapshot(gc))
+            {
+                const size_t cell_start = m_msg_buf.size();
+                _send_cell(gc,
+                           sc,
+                           m_next_view(gc),
+                           mc, env.map_knowledge(gc),
+                           new_monster_locs, force_full);
+                if (force_full)
+                    _store_cell_snapshot(gc, cell_start);
+            }
 
             if (!json_is_empty())
             {
@@ -1992,19 +2310,12 @@ void TilesFramework::redraw()
 
     m_text_menu.send();
 
-    _send_player();
     _send_messages();
 
+    // The player and map are sent when the frame ends.
+    m_player_update_pending = true;
     if (m_need_redraw && m_view_loaded)
-    {
-        if (m_current_flash_colour != m_next_flash_colour)
-        {
-            send_message("{\"msg\":\"flash\",\"col\":%d}",
-                         m_next_flash_colour);
-            m_current_flash_colour = m_next_flash_colour;
-        }
-        _send_map(false);
-    }
+        m_map_update_pending = true;
 
     m_need_redraw = false;
     m_last_tick_redraw = get_milliseconds();
@@ -8,6 +8,7 @@
 #ifdef USE_TILE_WEB
 
 #include <bitset>
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -152,8 +153,9 @@ public:
     void finish_message();
     void send_message(PRINTF(1, ));
     void flush_messages();
+    void flush_frame_updates();
 
-    bool has_receivers() { return !m_dest_addrs.empty(); }
+    bool has_receivers() { return !m_receivers.empty(); }
     bool is_controlled_from_web() { return m_controlled_from_web; }
 
     /* Webtiles can receive input both via stdin, and on the
@@ -220,14 +222,42 @@ protected:
     int m_sock;
     int m_max_msg_size;
     string m_msg_buf;
-    vector<sockaddr_un> m_dest_addrs;
+
+    /* A webserver process listening for our messages. Messages that could
+       not be sent straight away wait in its queue and are retried without
+       blocking, mostly from await_input(). */
+    struct Receiver
+    {
+        sockaddr_un addr;
+        deque<string> queue;    // whole messages, oldest first
+        size_t sent = 0;        // bytes of queue.front() already sent
+        size_t queued_bytes = 0;
+        bool resync = false;    // fell too far behind; resend everything
+    };
+    vector<Receiver> m_receivers;
 
     bool m_controlled_from_web;
     bool m_need_flush;
 
+    /* Messages finished since the last flush, joined into one so that the
+       webserver gets a single message per frame. The map and player
+       updates asked for by redraw() are held back until the frame ends,
+       so that several redraws in one frame only send them once. */
+    string m_frame_buf;
+    bool m_map_update_pending;
+    bool m_player_update_pending;
+
     bool _send_lock; // not thread safe
 
     void _await_connection();
+    void _send_frame();
+    void _send_to_receivers(const string &msg);
+    bool _send_fragments(const sockaddr_un &addr, const string &msg,
+                         size_t &sent);
+    bool _send_queued(Receiver &recv);
+    void _queue_message(Receiver &recv, const string &msg, size_t sent);
+    bool _has_queued_output() const;
+    void _service_receivers();
     wint_t _handle_control_message(sockaddr_un addr, string data);
     wint_t _receive_control_message();
 
@@ -287,6 +317,25 @@ protected:
     map<uint32_t, coord_def> m_monster_locs;
     bool m_need_full_map;
 
+    /* The JSON a full map send last wrote for a cell, along with everything
+       it was made from, so that sending the whole map again (say, when a
+       spectator joins) only has to re-serialise cells that changed. */
+    struct CellSnapshot
+    {
+        bool valid = false;
+        dungeon_feature_type feat;
+        map_feature mf;
+        char32_t glyph;
+        int col;
+        int base;
+        packed_cell tile; // map_knowledge is left empty
+        string json;
+    };
+    FixedArray<CellSnapshot, GXM, GYM> m_cell_snapshots;
+    void _fill_snapshot_key(const coord_def &gc, CellSnapshot &snap);
+    bool _send_cell_snapshot(const coord_def &gc);
+    void _store_cell_snapshot(const coord_def &gc, size_t json_start);
+
     coord_def m_cursor[CURSOR_MAX];
     coord_def m_last_clicked_grid;
     bool m_text_cursor;
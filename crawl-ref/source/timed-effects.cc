@@ -16,6 +16,7 @@
 #include "coordit.h"
 #include "corpse.h"
 #include "database.h"
+#include "dbg-prof.h"
 #include "dgn-shoals.h"
 #include "dgn-event.h"
 #include "env.h"
@@ -827,6 +828,8 @@ void monster::timeout_enchantments(int levels)
  */
 void update_level(int elapsedTime)
 {
+    prof_timer timer(PROF_UPDATE_LEVEL);
+
     ASSERT(!crawl_state.game_is_arena());
 
     const int turns = elapsedTime / 10;
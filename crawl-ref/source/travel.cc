@@ -3148,6 +3148,11 @@ static bool _find_transtravel_square(const level_pos &target, bool verbose)
             }
         }
 
+        // Read the level beyond the stair while we walk there.
+        LevelInfo &li = travel_cache.get_level_info(current);
+        if (const stair_info *si = li.get_stair(best_stair))
+            prefetch_level(si->destination.id);
+
         you.running.pos = best_stair;
         return true;
     }
@@ -3444,6 +3449,7 @@ void LevelInfo::update_excludes()
 
 void LevelInfo::update()
 {
+    alloc_scope scope(ALLOC_TRAVEL_CACHE);
     // First, set excludes, so that stair distances will be correctly populated.
     excludes = curr_excludes;
 
@@ -4233,6 +4239,7 @@ void TravelCache::save(writer& outf) const
 
 void TravelCache::load(reader& inf, int minorVersion)
 {
+    alloc_scope scope(ALLOC_TRAVEL_CACHE);
     levels.clear();
 
     // Check version. If not compatible, we just ignore the file altogether.
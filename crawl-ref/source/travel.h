@@ -11,6 +11,7 @@
 
 #include "command-type.h"
 #include "daction-type.h"
+#include "dbg-alloc.h"
 #include "exclude.h"
 #include "travel-defs.h"
 
@@ -415,6 +416,7 @@ public:
 
     LevelInfo& get_level_info(const level_id &lev)
     {
+        alloc_scope scope(ALLOC_TRAVEL_CACHE);
         LevelInfo &li = levels[lev];
         li.id = lev;
         return li;
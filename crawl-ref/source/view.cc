@@ -22,6 +22,7 @@
 #include "coord.h"
 #include "coordit.h"
 #include "database.h"
+#include "dbg-prof.h"
 #include "delay.h"
 #include "dgn-overview.h"
 #include "directn.h"
@@ -1348,6 +1349,8 @@ static bool _viewwindow_should_render()
  */
 void viewwindow(bool show_updates, bool tiles_only, animation *a, view_renderer *renderer)
 {
+    prof_timer timer(PROF_VIEWWINDOW);
+
     if (_view_is_updating)
     {
         // recursive calls to this function can lead to memory corruption or
@@ -1362,6 +1365,10 @@ void viewwindow(bool show_updates, bool tiles_only, animation *a, view_renderer
         return;
     }
 
+    // Nothing to draw on, e.g. in a headless arena run.
+    if (!crawl_state.io_inited)
+        return;
+
     {
         unwind_bool updating(_view_is_updating, true);
 
@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Which queued webtiles messages a slow receiver can do without.
+**/
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <utility>
+
+using std::deque;
+using std::string;
+
+/**
+ * Whether a message (one frame, possibly several JSON messages joined with
+ * commas) has to reach a receiver even if it fell behind, since resending
+ * the game state won't make up for it. That's anything for the webserver
+ * itself, and changes to the player's popups and menus: the player's client
+ * ignores the "ui-stack" sent on a resync, which is only for spectators.
+ */
+static inline bool web_message_must_arrive(const string &msg)
+{
+    if (!msg.empty() && msg[0] == '*')
+        return true;
+
+    static const char * const ui_msgs[] =
+    {
+        "\"msg\":\"ui-push\"", "\"msg\":\"ui-pop\"", "\"msg\":\"ui-state\"",
+        "\"msg\":\"menu\"", "\"msg\":\"update_menu\"",
+        "\"msg\":\"update_menu_items\"", "\"msg\":\"close_menu\"",
+        "\"msg\":\"close_all_menus\"",
+    };
+    for (const char *ui_msg : ui_msgs)
+        if (msg.find(ui_msg) != string::npos)
+            return true;
+    return false;
+}
+
+/**
+ * Drop the messages of a receiver's backlog that a resync will replace,
+ * keeping the rest in order. The front message stays too if sent bytes of it
+ * have gone out already, so that it never arrives truncated.
+ *
+ * @return the number of bytes left in the backlog.
+ */
+static inline size_t trim_web_backlog(deque<string> &queue, size_t sent)
+{
+    deque<string> kept;
+    size_t kept_bytes = 0;
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        if (web_message_must_arrive(queue[i]) || (i == 0 && sent > 0))
+        {
+            kept_bytes += queue[i].size();
+            kept.push_back(std::move(queue[i]));
+        }
+    }
+    queue.swap(kept);
+    return kept_bytes;
+}
@@ -8,6 +8,8 @@
 #include "wiz-fsim.h"
 
 #include <cerrno>
+#include <cmath>
+#include <functional>
 
 #include "beam.h"
 #include "bitary.h"
@@ -33,11 +35,14 @@
 #include "output.h"
 #include "player-equip.h"
 #include "player.h"
+#include "random.h"
 #include "ranged-attack.h"
 #include "skills.h"
 #include "species.h"
 #include "state.h"
 #include "stringutil.h"
+#include "syscalls.h"
+#include "tags.h"
 #include "throw.h"
 #include "unwind.h"
 #include "version.h"
@@ -145,12 +150,16 @@ static void _write_version(FILE * o)
 
 static void _write_matchup(FILE * o, monster &mon, bool defend, int iter_limit)
 {
-    fprintf(o, "%s: %s %s vs. %s (%d rounds) (%s)\n",
+    const string rounds = Options.fsim_precision
+        ? make_stringf("up to %d rounds, +/-%d%% at 95%% confidence",
+                       iter_limit, Options.fsim_precision)
+        : make_stringf("%d rounds", iter_limit);
+    fprintf(o, "%s: %s %s vs. %s (%s) (%s)\n",
             defend ? "Defense" : "Attack",
             species_name(you.species).c_str(),
             get_job_name(you.char_class),
             mon.name(DESC_PLAIN, true).c_str(),
-            iter_limit,
+            rounds.c_str(),
             _time_string().c_str());
 }
 
@@ -436,11 +445,32 @@ static void _do_one_fsim_round(monster &mon, fight_data &fd, bool defend)
     you.move_to_pos(you_start_pos);
 }
 
+// With fsim_precision, check whether to stop every this many rounds, once
+// there have been at least FSIM_MIN_ROUNDS of them.
+#define FSIM_CHECK_ROUNDS 500
+#define FSIM_MIN_ROUNDS 1000
+
+/**
+ * Is the mean damage per round known well enough for fsim_precision? That is,
+ * is the half-width of its 95% confidence interval within fsim_precision
+ * percent of the mean?
+ *
+ * @param rounds  The number of rounds so far.
+ * @param sum     The total damage over those rounds.
+ * @param sum_sq  The sum of the squares of each round's damage.
+ */
+static bool _fsim_precise_enough(int rounds, double sum, double sum_sq)
+{
+    const double mean = sum / rounds;
+    const double variance = max(0.0, (sum_sq - sum * mean) / (rounds - 1));
+    const double half_width = 1.96 * sqrt(variance / rounds);
+    return half_width <= mean * Options.fsim_precision / 100;
+}
+
 static fight_data _get_fight_data(monster &mon, int iter_limit, bool defend)
 {
     const monster orig = mon;
     fight_data fdata;
-    fdata.monster.iterations = fdata.player.iterations = iter_limit;
 
     // now make sure the player is ready
     unwind_var<int> exp_available(you.exp_available, 0);
@@ -456,8 +486,29 @@ static fight_data _get_fight_data(monster &mon, int iter_limit, bool defend)
     {
         msg::suppress mx;
 
-        for (int i = 0; i < iter_limit; i++)
+        // The side whose damage is being measured.
+        const fight_damage_stats &measured = defend ? fdata.monster
+                                                    : fdata.player;
+        double sum = 0, sum_sq = 0;
+        int rounds = 0;
+        while (rounds < iter_limit)
+        {
+            const unsigned int before = measured.cumulative_damage;
             _do_one_fsim_round(mon, fdata, defend);
+            const double dam = measured.cumulative_damage - before;
+            sum += dam;
+            sum_sq += dam * dam;
+            ++rounds;
+
+            if (Options.fsim_precision
+                && rounds >= FSIM_MIN_ROUNDS
+                && rounds % FSIM_CHECK_ROUNDS == 0
+                && _fsim_precise_enough(rounds, sum, sum_sq))
+            {
+                break;
+            }
+        }
+        fdata.monster.iterations = fdata.player.iterations = rounds;
     }
 
     fdata.player.calc_output_stats();
@@ -517,6 +568,124 @@ void wizard_quick_fsim()
     return;
 }
 
+// Sets up the player for one point of a scale, e.g. by setting skill levels.
+typedef function<void(int point)> fsim_setup;
+
+// The player as they were before the first point of a scale.
+struct fsim_start
+{
+    skill_state skills;
+    int xl;
+    unsigned int experience;
+
+    fsim_start() : xl(you.experience_level), experience(you.experience)
+    {
+        skills.save();
+    }
+
+    void restore()
+    {
+        if (you.experience_level != xl)
+            set_xl(xl, false);
+        you.experience = experience;
+        skills.restore_levels();
+        skills.restore_training();
+    }
+};
+
+/**
+ * Run the fight for one point of a scale. Each point starts from the same
+ * player and draws from its own substream of the given seed (setup included,
+ * since XL training uses the RNG), so that a point gives the same result
+ * whichever points ran before it and however they are split between
+ * processes.
+ */
+static fight_data _fsim_point(monster &mon, bool defend, uint64_t seed,
+                              int point, fsim_start &start,
+                              const fsim_setup &setup)
+{
+    rng::subgenerator point_rng(seed, point);
+    start.restore();
+    setup(point);
+    return _get_fight_data(mon, Options.fsim_rounds, defend);
+}
+
+#ifndef TARGET_OS_WINDOWS
+static void _marshall_fsim_stats(writer &th, const fight_damage_stats &stats)
+{
+    marshallUnsigned(th, stats.cumulative_damage);
+    marshallSigned(th, stats.time_taken);
+    marshallSigned(th, stats.hits);
+    marshallSigned(th, stats.iterations);
+    marshallSigned(th, stats.max_dam);
+}
+
+static void _unmarshall_fsim_stats(reader &th, fight_damage_stats &stats)
+{
+    stats.cumulative_damage = unmarshallUnsigned(th);
+    stats.time_taken = unmarshallSigned(th);
+    stats.hits = unmarshallSigned(th);
+    stats.iterations = unmarshallSigned(th);
+    stats.max_dam = unmarshallSigned(th);
+    stats.calc_output_stats();
+}
+#endif
+
+/**
+ * Run all the points of a scale spread over fsim_jobs worker processes.
+ *
+ * @return the fight data for each point, or an empty vector if the points
+ *         should be run one at a time here instead: either only one job
+ *         was asked for, or a worker failed.
+ */
+static vector<fight_data> _fsim_points_parallel(monster &mon, bool defend,
+                                                uint64_t seed, int points,
+                                                fsim_start &start,
+                                                const fsim_setup &setup)
+{
+#ifdef TARGET_OS_WINDOWS
+    UNUSED(mon, defend, seed, points, start, setup);
+    return {};
+#else
+    const int jobs = min(Options.fsim_jobs, points);
+    if (jobs <= 1)
+        return {};
+
+    auto results = run_forked_jobs(jobs, [&](int job)
+    {
+        crawl_state.io_inited = false;
+        msg::suppress mx;
+        vector<unsigned char> buf;
+        writer th(&buf);
+        for (int point = job; point < points; point += jobs)
+        {
+            const fight_data fdata = _fsim_point(mon, defend, seed, point,
+                                                 start, setup);
+            _marshall_fsim_stats(th, fdata.player);
+            _marshall_fsim_stats(th, fdata.monster);
+        }
+        return buf;
+    });
+
+    vector<fight_data> fights(points);
+    for (int job = 0; job < jobs; job++)
+    {
+        if (results[job].empty())
+        {
+            mprf(MSGCH_ERROR, "fsim worker %d failed; running serially.", job);
+            return {};
+        }
+        reader th(results[job]);
+        for (int point = job; point < points; point += jobs)
+        {
+            _unmarshall_fsim_stats(th, fights[point].player);
+            _unmarshall_fsim_stats(th, fights[point].monster);
+        }
+    }
+    return fights;
+#endif
+}
+
 static string _init_scale(skill_map &scale, bool &xl_mode)
 {
     string ret;
@@ -555,13 +724,6 @@ static string _init_scale(skill_map &scale, bool &xl_mode)
             ret = skill_name(sk);
     }
 
-    if (xl_mode)
-    {
-        you.training.init(0);
-        for (const auto &entry : scale)
-            you.training[entry.first] = entry.second;
-    }
-
     return ret;
 }
 
@@ -590,21 +752,39 @@ static void _fsim_simple_scale(FILE * o, monster* mon, bool defense)
     fprintf(o, "%s\n", file_title.c_str());
     mpr(text_title);
 
-    vector<pair<int, fight_data>> results;
-    const int iter_limit = Options.fsim_rounds;
-    for (int i = xl_mode ? 1 : 0; i <= 27; i++)
+    // Point i is skill level (or XL) first + i.
+    const int first = xl_mode ? 1 : 0;
+    const int points = 28 - first;
+    const fsim_setup setup = [&](int point)
     {
-        clear_messages();
-
+        const int level = first + point;
         if (xl_mode)
-            set_xl(i, true);
+        {
+            you.training.init(0);
+            for (const auto &entry : scale)
+                you.training[entry.first] = entry.second;
+            set_xl(level, true);
+        }
         else
         {
             for (const auto &entry : scale)
-                set_skill_level(entry.first, i / entry.second);
+                set_skill_level(entry.first, level / entry.second);
         }
+    };
+    fsim_start start;
+    const uint64_t seed = rng::get_uint64();
+    const vector<fight_data> parallel =
+        _fsim_points_parallel(*mon, defense, seed, points, start, setup);
 
-        fight_data fdata = _get_fight_data(*mon, iter_limit, defense);
+    vector<pair<int, fight_data>> results;
+    for (int point = 0; point < points; point++)
+    {
+        const int i = first + point;
+        clear_messages();
+
+        fight_data fdata = parallel.empty()
+            ? _fsim_point(*mon, defense, seed, point, start, setup)
+            : parallel[point];
         results.emplace_back(i, fdata);
         fight_damage_stats &fstats = defense ? fdata.monster : fdata.player;
         const string line = fstats.summary(make_stringf("%2d | ", i), false);
@@ -616,7 +796,7 @@ static void _fsim_simple_scale(FILE * o, monster* mon, bool defense)
         fflush(o);
 
         // kill the loop if the user hits escape
-        if (kbhit() && getch_ck() == 27)
+        if (parallel.empty() && kbhit() && getch_ck() == 27)
         {
             mpr("Cancelling simulation.\n");
             fprintf(o, "Simulation cancelled!\n\n");
@@ -664,16 +844,29 @@ static void _fsim_double_scale(FILE * o, monster* mon, bool defense)
 
     fprintf(o,"\n");
 
-    const int iter_limit = Options.fsim_rounds;
+    // Point p is column p % 14 and row p / 14 of the grid, each of which
+    // goes 1, 3, ... 27.
+    const int side = 14;
+    const fsim_setup setup = [&](int point)
+    {
+        set_skill_level(skx, 1 + 2 * (point % side));
+        set_skill_level(sky, 1 + 2 * (point / side));
+    };
+    fsim_start start;
+    const uint64_t seed = rng::get_uint64();
+    const vector<fight_data> parallel =
+        _fsim_points_parallel(*mon, defense, seed, side * side, start, setup);
+
     for (int y = 1; y <= 27; y += 2)
     {
         fprintf(o, Options.fsim_csv ? "%d\t" : "%2d", y);
         for (int x = 1; x <= 27; x += 2)
         {
             clear_messages();
-            set_skill_level(skx, x);
-            set_skill_level(sky, y);
-            fight_data fdata = _get_fight_data(*mon, iter_limit, defense);
+            const int point = (y / 2) * side + x / 2;
+            fight_data fdata = parallel.empty()
+                ? _fsim_point(*mon, defense, seed, point, start, setup)
+                : parallel[point];
             fight_damage_stats &fstats = defense ? fdata.monster : fdata.player;
             mprf("%s %d, %s %d: %d", skill_name(skx), x, skill_name(sky), y,
                  int(fstats.av_eff_dam));
@@ -681,7 +874,7 @@ static void _fsim_double_scale(FILE * o, monster* mon, bool defense)
             fflush(o);
 
             // kill the loop if the user hits escape
-            if (kbhit() && getch_ck() == 27)
+            if (parallel.empty() && kbhit() && getch_ck() == 27)
             {
                 mpr("Cancelling simulation.\n");
                 fprintf(o, "\nSimulation cancelled!\n\n");
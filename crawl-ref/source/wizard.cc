@@ -14,6 +14,9 @@
 #include "cio.h" // cursor_control
 #include "clua.h"
 #include "command.h" // show_keyhelp_menu
+#include "dbg-alloc.h"
+#include "dbg-luaprof.h"
+#include "dbg-prof.h"
 #include "dbg-util.h"
 #include "dgn-shoals.h" // wizard_mod_tide
 #include "files.h" // save_game
@@ -122,7 +125,7 @@ static void _do_wizard_command(int wiz_command)
     // case CONTROL('M'): break; // XXX do not use, menu command
 
     case 'n': wizard_set_zot_clock(); break;
-    // case 'N': break;
+    case 'N': debug_memory_report(); break;
     // case CONTROL('N'): break;
 
     case 'o': wizard_create_spec_object(); break;
@@ -134,7 +137,7 @@ static void _do_wizard_command(int wiz_command)
     case CONTROL('P'): wizard_list_props(); break;
 
     // case 'q': break;
-    // case 'Q': break;
+    case 'Q': debug_turn_profile(); break;
     case CONTROL('Q'): wizard_toggle_dprf(); break;
 
     case 'r': wizard_change_species(); break;
@@ -150,7 +153,7 @@ static void _do_wizard_command(int wiz_command)
     case CONTROL('T'): debug_terp_dlua(); break;
 
     case 'u': wizard_level_travel(false); break;
-    // case 'U': break;
+    case 'U': debug_lua_profile(); break;
     case CONTROL('U'): debug_terp_dlua(clua); break;
 
     case 'v': wizard_recharge_evokers(); break;
@@ -501,6 +504,9 @@ int list_wizard_commands(bool do_redraw_screen)
                        "<w>Ctrl-F</w> double scale fsim\n"
                        "<w>Ctrl-I</w> item generation stats\n"
                        "<w>O</w>      measure exploration time\n"
+                       "<w>N</w>      memory use by subsystem\n"
+                       "<w>Q</w>      turn phase timings\n"
+                       "<w>U</w>      Lua function timings\n"
                        "<w>Ctrl-T</w> dungeon (D)Lua interpreter\n"
                        "<w>Ctrl-U</w> client (C)Lua interpreter\n"
                        "<w>Ctrl-X</w> Xom effect stats\n"